@@ -7,20 +7,230 @@
 #define MAXMBOX         2000    /* 500 */
 #define MAXSLOTS        2500    /* 5000 */
 #define MAX_MESSAGE     256     /* largest possible message in a single slot */
+#define MAX_RECEIVE_ANY 16      /* most mailboxes a single mailbox_receive_any call waits on */
+#define MAILBOX_TIMEOUT -4      /* returned by the timed calls when the timeout runs out */
+#define MAX_PERIODIC_TIMERS 1024    /* periodic timers that can be running at once */
+
+/* order in which processes blocked on a mailbox are woken */
+#define MBOX_WAKE_FIFO      0   /* first blocked, first woken */
+#define MBOX_WAKE_PRIORITY  1   /* highest wake priority first, FIFO among equals */
+
+/* message priorities for mailbox_send_prio: 0 (bulk, what mailbox_send uses) to MESSAGE_LANES - 1 (most urgent) */
+#define MESSAGE_LANES       4
+
+/* what wait_device_set_overflow makes an I/O device do with events that arrive while its event ring is full */
+#define DEVICE_OVERFLOW_COALESCE 0  /* fold them into one event: wait_device returns their count and the last status */
+#define DEVICE_OVERFLOW_DROP     1  /* drop them and count them in device_stats_t.dropped */
+
+/* event counters of one I/O device, filled in by wait_device_get_stats */
+typedef struct
+{
+    int events;         /* interrupts the device has raised */
+    int dropped;        /* events dropped because the event ring was full */
+    int coalesced;      /* events folded into coalesced runs */
+    int pending;        /* events not yet taken by wait_device */
+} device_stats_t;
+
+/* traffic counters of one mailbox, filled in by mailbox_get_stats */
+typedef struct
+{
+    int sends;                  /* messages sent */
+    int receives;               /* messages received */
+    int blockedSends;           /* sends that had to block */
+    int blockedReceives;        /* receives that had to block */
+    int wouldBlock;             /* non-blocking sends and receives that returned -2 */
+    int depth;                  /* messages queued now */
+    int peakDepth;              /* most messages queued at once */
+    long long bytesSent;        /* payload bytes of the messages sent */
+    long long bytesReceived;    /* payload bytes of the messages received */
+} mailbox_stats_t;
+
+/* blocking-time histogram of one mailbox, filled in by mailbox_get_latency and wait_device_get_latency;
+ * times are in read_clock() microseconds, p50 and p99 are the top of the bucket they fall in */
+#define MAILBOX_LATENCY_BUCKETS 32
+typedef struct
+{
+    int samples;                /* blocked calls that have finished */
+    unsigned int p50;
+    unsigned int p99;
+    unsigned int max;
+    unsigned int buckets[MAILBOX_LATENCY_BUCKETS];  /* [0] under 1 us, [b] 2^(b-1) to 2^b - 1 us, the last one open-ended */
+} mailbox_latency_t;
+
+/* kinds of record in the mailbox event trace */
+#define MAILBOX_TRACE_SEND      1   /* a message was sent, size is its size */
+#define MAILBOX_TRACE_RECEIVE   2   /* a message was received, size is its size */
+#define MAILBOX_TRACE_BLOCK     3   /* pid blocked on mboxId (-1 for sleeps, the device mailbox for device waits) */
+#define MAILBOX_TRACE_UNBLOCK   4   /* pid was woken from a block on mboxId */
+#define MAILBOX_TRACE_FREE      5   /* mboxId was freed, size is the # of messages it still held */
+#define MAILBOX_TRACE_DEVICE    6   /* I/O device interrupt, mboxId is the device mailbox, size the status */
+
+/* one record of the mailbox event trace */
+typedef struct
+{
+    uint64_t timestamp;         /* trace clock when the event was recorded, see mailbox_trace_header_t */
+    int32_t event;              /* MAILBOX_TRACE_* */
+    int32_t pid;                /* process that made the call, was woken, or was running at the interrupt */
+    int32_t mboxId;
+    int32_t size;
+} mailbox_trace_record_t;
+
+/* start of a file written by mailbox_trace_dump, followed by recordCount records, oldest first */
+typedef struct
+{
+    char magic[4];              /* "MBTR" */
+    uint32_t version;           /* 2 */
+    uint32_t recordSize;        /* sizeof(mailbox_trace_record_t) */
+    uint32_t recordCount;
+    uint32_t overwritten;       /* older records the ring no longer held */
+    uint32_t startClock;        /* read_clock() when the trace was started or last reset */
+    uint64_t startStamp;        /* trace clock at the same moment */
+    uint64_t endStamp;          /* trace clock when the trace was dumped */
+    uint32_t endClock;          /* read_clock() at the same moment */
+} mailbox_trace_header_t;
+
+/* The trace clock is the CPU time-stamp counter where there is one, otherwise
+ * read_clock(). A record's time in read_clock() microseconds is
+ *   startClock + (timestamp - startStamp) * (endClock - startClock) / (endStamp - startStamp) */
+
+/* system call numbers of the mailbox API in systemCallVector; the handler leaves the result in arguments[0] */
+#define SYS_MAILBOX_CREATE  1
+#define SYS_MAILBOX_FREE    2
+#define SYS_MAILBOX_SEND    3
+#define SYS_MAILBOX_RECEIVE 4
+#define SYS_WAIT_DEVICE     5
+
+/* slot usage of one mailbox, filled in by mailbox_get_usage */
+typedef struct
+{
+    int capacity;       /* slots the mailbox was created with */
+    int queued;         /* messages waiting to be received */
+    int slotsInUse;     /* pool slots held now: queued, reserved and acquired */
+    int slotsPeak;      /* most pool slots held at once */
+    int minReserved;    /* slots guaranteed to the mailbox, 0 if none */
+    int maxQuota;       /* most slots the mailbox may hold, 0 if no quota */
+    int quotaRejects;   /* sends turned away (or made to wait) by the quota */
+} mailbox_usage_t;
 
 /* returns id of mailbox, or -1 if no more mailboxes or error */
 int mailbox_create(int slots, int slot_size);
 
+/* like mailbox_create, but messages live in a contiguous ring reserved at create time */
+int mailbox_create_ring(int slots, int slot_size);
+
+/* like mailbox_create, but with a wake policy for blocked senders and receivers */
+int mailbox_create_policy(int slots, int slot_size, int wake_policy);
+
+/* like mailbox_create, but each msg sent is stored once and received once by every subscription */
+int mailbox_create_multicast(int slots, int slot_size);
+
+/* returns the id of a new subscription to a multicast mailbox, -1 if invalid args or no more mailboxes.
+ * Receive from the subscription id; mailbox_free on it unsubscribes. */
+int mailbox_subscribe(int mbox_id);
+
+/* sets the caller's wake priority in MBOX_WAKE_PRIORITY mailboxes, returns 0 if successful, -1 if out of range */
+extern int mailbox_set_wake_priority(int priority);
+
 /* returns 0 if successful, -1 if invalid arg */
 extern int mailbox_free(int mbox_id);
 
 /* returns 0 if successful, -1 if invalid args */
 extern int mailbox_send(int mbox_id, void* msg_ptr, int msg_size, BOOL block);
 
+/* like mailbox_send, but queued in lane priority; receives take the highest non-empty lane first */
+extern int mailbox_send_prio(int mbox_id, void* msg_ptr, int msg_size, int priority, BOOL block);
+
 /* returns size of received msg if successful, -1 if invalid args */
 extern int mailbox_receive(int mbox_id, void* msg_ptr, int msg_max_size, BOOL block);
 
+/* sends up to count msgs under one critical section, returns # sent, -1 if invalid args, -2 if none fit */
+extern int mailbox_send_batch(int mbox_id, void* msg_ptrs[], int msg_sizes[], int count, BOOL block);
+
+/* receives up to count msgs under one critical section, returns # received, -1 if invalid args, -2 if none queued */
+extern int mailbox_receive_batch(int mbox_id, void* msg_ptrs[], int msg_max_size, int msg_sizes[], int count, BOOL block);
+
+/* like mailbox_send, but waits at most timeout_ms; returns MAILBOX_TIMEOUT if it ran out */
+extern int mailbox_send_timed(int mbox_id, void* msg_ptr, int msg_size, int timeout_ms);
+
+/* like mailbox_receive, but waits at most timeout_ms; returns MAILBOX_TIMEOUT if it ran out */
+extern int mailbox_receive_timed(int mbox_id, void* msg_ptr, int msg_max_size, int timeout_ms);
+
+/* receives from the first of n mailboxes with a msg, *which = its position in ids[], returns size of msg, -1 if invalid args, -2 if none has one */
+extern int mailbox_receive_any(int ids[], int n, int* which, void* msg_ptr, int msg_max_size, BOOL block);
+
+/* zero-copy send: returns 0 and a writable slot buffer in *msg_ptr, -1 if invalid args, -2 if mailbox full */
+extern int mailbox_send_reserve(int mbox_id, int msg_size, void** msg_ptr, BOOL block);
+
+/* publishes a reserved slot, returns 0 if successful, -1 if invalid args */
+extern int mailbox_send_commit(int mbox_id, void* msg_ptr);
+
+/* zero-copy receive: returns size of msg and its slot buffer in *msg_ptr, -1 if invalid args */
+extern int mailbox_receive_acquire(int mbox_id, void** msg_ptr, BOOL block);
+
+/* gives back an acquired slot, returns 0 if successful, -1 if invalid args */
+extern int mailbox_receive_release(int mbox_id, void* msg_ptr);
+
+/* sets the reserved minimum and the quota (0 = none) in slots, returns 0 if successful, -1 if invalid args or pool too small */
+extern int mailbox_set_quota(int mbox_id, int min_slots, int max_slots);
+
+/* fills in the slot usage of a mailbox, returns 0 if successful, -1 if invalid args */
+extern int mailbox_get_usage(int mbox_id, mailbox_usage_t* usage);
+
+/* fills in the traffic counters of a mailbox, returns 0 if successful, -1 if invalid args */
+extern int mailbox_get_stats(int mbox_id, mailbox_stats_t* stats);
+
+/* prints the counters of every mailbox in use */
+extern void display_mailbox_table(void);
+
+/* fills in the blocking-time histogram of a mailbox, returns 0 if successful, -1 if invalid args */
+extern int mailbox_get_latency(int mbox_id, mailbox_latency_t* latency);
+
+/* prints p50, p99 and max blocking time of every mailbox in use that has blocked */
+extern void display_mailbox_latency(void);
+
+/* writes the event trace to a file, returns # of records written, -1 if invalid args, a dump is in progress, or the file cannot be written */
+extern int mailbox_trace_dump(char* fileName);
+
+/* empties the event trace */
+extern void mailbox_trace_reset(void);
+
+/* blocks the caller for at least ms milliseconds, returns 0, -1 if invalid args, -5 if signaled */
+extern int k_sleep(int ms);
+
+/* starts a timer that expires every period_ms, returns its id, -1 if invalid args or no timers left */
+extern int periodic_timer_start(int period_ms);
+
+/* waits for the next expiry, returns # of expiries since the last wait, -1 if invalid args or stopped, -5 if signaled */
+extern int periodic_timer_wait(int timer_id);
+
+/* stops a periodic timer and fails its waiter with -1, returns 0 if successful, -1 if invalid args */
+extern int periodic_timer_stop(int timer_id);
+
+/* user-mode stubs: same arguments and results as the kernel calls, made through system_call() */
+extern int sys_mailbox_create(int slots, int slot_size);
+extern int sys_mailbox_free(int mbox_id);
+extern int sys_mailbox_send(int mbox_id, void* msg_ptr, int msg_size, BOOL block);
+extern int sys_mailbox_receive(int mbox_id, void* msg_ptr, int msg_max_size, BOOL block);
+extern int sys_wait_device(char* deviceName, int* status);
+
 /* type = interrupt device type, unit = # of device (when more than one),
  * status = where interrupt handler puts device's status register.
+ * For the clock, returns the # of clock ticks since the caller last waited on it.
+ * For an I/O device, returns 0 for one event, or the # of events coalesced into *status (the last one's status).
  */
-extern int wait_device(char* deviceName, int* status);
\ No newline at end of file
+extern int wait_device(char* deviceName, int* status);
+
+/* returns a handle for wait_device_h, -1 if not an initialized device */
+extern int wait_device_open(char* deviceName);
+
+/* wait_device on a handle from wait_device_open, skipping the name lookup; -1 if invalid handle */
+extern int wait_device_h(int handle, int* status);
+
+/* sets DEVICE_OVERFLOW_COALESCE or DEVICE_OVERFLOW_DROP for an I/O device, returns 0 if successful, -1 if invalid args */
+extern int wait_device_set_overflow(char* deviceName, int mode);
+
+/* fills in the event counters of an I/O device, returns 0 if successful, -1 if invalid args */
+extern int wait_device_get_stats(char* deviceName, device_stats_t* stats);
+
+/* fills in the blocking-time histogram of wait_device on a device, returns 0 if successful, -1 if invalid args */
+extern int wait_device_get_latency(char* deviceName, mailbox_latency_t* latency);
\ No newline at end of file
@@ -0,0 +1,131 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define ROUND_TRIPS     20000
+
+int EchoProcess(char* strArgs);
+int ParkedProcess(char* strArgs);
+
+int mailboxPing;
+int mailboxPong;
+int mailboxReady;
+int mailboxPark;
+
+/*********************************************************************************
+*
+* MessagingBench01 - Blocking Round Trip Cost
+*
+* Measures the cost of one blocking round trip between two processes: the
+* parent sends on a zero-slot mailbox and then receives the reply from a second
+* zero-slot mailbox, while an echo child does the opposite. Every message
+* blocks one side and wakes the other, so each round trip runs the full
+* block/wakeup bookkeeping of the messaging layer four times.
+*
+* The run is repeated with 0, 16 and 40 extra processes parked in a blocking
+* receive. Parked processes hold messaging process table entries, so any
+* per-message lookup that scans that table gets slower as the count grows.
+*
+* Output is one line per run:
+*   BENCH bench=round_trip parked=<n> iterations=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int parkedCounts[] = { 0, 16, 40 };
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int run = 0; run < sizeof(parkedCounts) / sizeof(parkedCounts[0]); run++)
+    {
+        int parked = parkedCounts[run];
+        DWORD startTime, endTime;
+
+        mailboxPing = mailbox_create(0, sizeof(int));
+        mailboxPong = mailbox_create(0, sizeof(int));
+        mailboxReady = mailbox_create(parked + 1, 0);
+        mailboxPark = mailbox_create(0, 0);
+
+        /* Park the extra processes first so they hold the low table entries. */
+        for (int i = 0; i < parked; i++)
+        {
+            snprintf(nameBuffer, sizeof(nameBuffer), "%s-Parked%d", testName, i);
+            k_spawn(nameBuffer, ParkedProcess, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+        }
+        for (int i = 0; i < parked; i++)
+        {
+            mailbox_receive(mailboxReady, NULL, 0, TRUE);
+        }
+
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Echo", testName);
+        k_spawn(nameBuffer, EchoProcess, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+
+        startTime = read_clock();
+        for (int i = 0; i < ROUND_TRIPS; i++)
+        {
+            int value = i;
+
+            mailbox_send(mailboxPing, &value, sizeof(value), TRUE);
+            mailbox_receive(mailboxPong, &value, sizeof(value), TRUE);
+        }
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=round_trip parked=%d iterations=%d total_us=%u ns_per_op=%u\n",
+            parked, ROUND_TRIPS, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / ROUND_TRIPS));
+
+        /* Freeing the park mailbox releases the parked processes. */
+        mailbox_free(mailboxPark);
+        for (int i = 0; i < parked + 1; i++)
+        {
+            k_wait(&status);
+        }
+
+        mailbox_free(mailboxPing);
+        mailbox_free(mailboxPong);
+        mailbox_free(mailboxReady);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* EchoProcess
+*
+* Receives each ping and sends it straight back on the pong mailbox.
+*********************************************************************************/
+int EchoProcess(char* strArgs)
+{
+    int value;
+
+    for (int i = 0; i < ROUND_TRIPS; i++)
+    {
+        mailbox_receive(mailboxPing, &value, sizeof(value), TRUE);
+        mailbox_send(mailboxPong, &value, sizeof(value), TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* ParkedProcess
+*
+* Reports ready, then blocks on the park mailbox until it is freed.
+*********************************************************************************/
+int ParkedProcess(char* strArgs)
+{
+    mailbox_send(mailboxReady, NULL, 0, FALSE);
+    mailbox_receive(mailboxPark, NULL, 0, TRUE);
+
+    k_exit(0);
+    return 0;
+}
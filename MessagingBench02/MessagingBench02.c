@@ -0,0 +1,129 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TOTAL_MESSAGES  64000
+#define MAILBOX_SLOTS   64
+#define MESSAGE_SIZE    16
+#define MAX_BATCH       64
+
+int BatchConsumer(char* strArgs);
+
+int mailboxId;
+int batchSize;
+
+/*********************************************************************************
+*
+* MessagingBench02 - Batch Throughput
+*
+* A producer (the parent) pushes TOTAL_MESSAGES 16-byte messages through a
+* 64-slot mailbox to a consumer child of the same priority. Both sides block
+* when the mailbox is full or empty.
+*
+* The run is repeated with mailbox_send / mailbox_receive one message at a
+* time, and with mailbox_send_batch / mailbox_receive_batch at batch sizes
+* 1, 8 and 64.
+*
+* Output is one line per run:
+*   BENCH bench=batch mode=<single|batch> batch=<n> messages=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int batchSizes[] = { 0, 1, 8, 64 };         /* 0 = single-message calls */
+    char messages[MAX_BATCH][MESSAGE_SIZE];
+    void* pMsgs[MAX_BATCH];
+    int sizes[MAX_BATCH];
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int i = 0; i < MAX_BATCH; i++)
+    {
+        memset(messages[i], 'x', MESSAGE_SIZE);
+        pMsgs[i] = messages[i];
+        sizes[i] = MESSAGE_SIZE;
+    }
+
+    for (int run = 0; run < sizeof(batchSizes) / sizeof(batchSizes[0]); run++)
+    {
+        DWORD startTime, endTime;
+        int sent = 0;
+
+        batchSize = batchSizes[run];
+        mailboxId = mailbox_create(MAILBOX_SLOTS, MESSAGE_SIZE);
+
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Consumer", testName);
+        k_spawn(nameBuffer, BatchConsumer, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+
+        startTime = read_clock();
+        while (sent < TOTAL_MESSAGES)
+        {
+            if (batchSize == 0)
+            {
+                mailbox_send(mailboxId, messages[0], MESSAGE_SIZE, TRUE);
+                sent++;
+            }
+            else
+            {
+                int count = TOTAL_MESSAGES - sent < batchSize ? TOTAL_MESSAGES - sent : batchSize;
+                int result = mailbox_send_batch(mailboxId, pMsgs, sizes, count, TRUE);
+                if (result > 0)
+                    sent += result;
+            }
+        }
+        k_wait(&status);
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=batch mode=%s batch=%d messages=%d total_us=%u ns_per_op=%u\n",
+            batchSize == 0 ? "single" : "batch", batchSize == 0 ? 1 : batchSize, TOTAL_MESSAGES,
+            endTime - startTime, (unsigned)(((endTime - startTime) * 1000ULL) / TOTAL_MESSAGES));
+
+        mailbox_free(mailboxId);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* BatchConsumer
+*
+* Receives TOTAL_MESSAGES messages using the same call style as the producer.
+*********************************************************************************/
+int BatchConsumer(char* strArgs)
+{
+    char messages[MAX_BATCH][MESSAGE_SIZE];
+    void* pMsgs[MAX_BATCH];
+    int sizes[MAX_BATCH];
+    int received = 0;
+
+    for (int i = 0; i < MAX_BATCH; i++)
+    {
+        pMsgs[i] = messages[i];
+    }
+
+    while (received < TOTAL_MESSAGES)
+    {
+        if (batchSize == 0)
+        {
+            mailbox_receive(mailboxId, messages[0], MESSAGE_SIZE, TRUE);
+            received++;
+        }
+        else
+        {
+            int result = mailbox_receive_batch(mailboxId, pMsgs, MESSAGE_SIZE, sizes, batchSize, TRUE);
+            if (result > 0)
+                received += result;
+        }
+    }
+
+    k_exit(0);
+    return 0;
+}
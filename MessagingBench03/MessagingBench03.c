@@ -0,0 +1,68 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TOTAL_MESSAGES  200000
+#define MESSAGE_SIZE    16
+
+/*********************************************************************************
+*
+* MessagingBench03 - Ring vs Linked Slot Mailboxes
+*
+* Fills a mailbox to the given depth with non-blocking sends, then drains it
+* with non-blocking receives, until TOTAL_MESSAGES 16-byte messages have gone
+* through. Runs each depth (10, 100, 1000) once with a linked-slot mailbox
+* from mailbox_create and once with a ring mailbox from mailbox_create_ring.
+*
+* Output is one line per run:
+*   BENCH bench=ring mode=<linked|ring> depth=<n> messages=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int depths[] = { 10, 100, 1000 };
+    char message[MESSAGE_SIZE];
+
+    console_output(FALSE, "\n%s: started\n", testName);
+    memset(message, 'x', sizeof(message));
+
+    for (int d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+    {
+        for (int ring = 0; ring < 2; ring++)
+        {
+            int depth = depths[d];
+            int mboxId = ring ? mailbox_create_ring(depth, MESSAGE_SIZE) : mailbox_create(depth, MESSAGE_SIZE);
+            int moved = 0;
+            DWORD startTime, endTime;
+
+            startTime = read_clock();
+            while (moved < TOTAL_MESSAGES)
+            {
+                for (int i = 0; i < depth; i++)
+                {
+                    mailbox_send(mboxId, message, MESSAGE_SIZE, FALSE);
+                }
+                for (int i = 0; i < depth; i++)
+                {
+                    mailbox_receive(mboxId, message, MESSAGE_SIZE, FALSE);
+                }
+                moved += depth;
+            }
+            endTime = read_clock();
+
+            console_output(FALSE, "BENCH bench=ring mode=%s depth=%d messages=%d total_us=%u ns_per_op=%u\n",
+                ring ? "ring" : "linked", depth, moved, endTime - startTime,
+                (unsigned)(((endTime - startTime) * 1000ULL) / moved));
+
+            mailbox_free(mboxId);
+        }
+    }
+
+    k_exit(0);
+    return 0;
+}
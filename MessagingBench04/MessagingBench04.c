@@ -0,0 +1,95 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define OUTSTANDING_TIMERS  1000
+#define ARM_OPS             100000
+#define SLEEP_COUNT         100
+#define SLEEP_MS            60
+
+int timerIds[OUTSTANDING_TIMERS];
+
+/*********************************************************************************
+*
+* MessagingBench04 - Timer Wheel
+*
+* Run 1 arms OUTSTANDING_TIMERS periodic timers with periods from 20 ms to
+* 20 s, then times ARM_OPS periodic_timer_start / periodic_timer_stop pairs
+* with all of them still armed.
+*
+* Run 2 times SLEEP_COUNT calls of k_sleep(SLEEP_MS), once with no other
+* timers and once with the OUTSTANDING_TIMERS periodic timers running. Each
+* run lasts longer than a turn of the inner wheel (5.12 s), so the long
+* timers are moved down from the outer wheel during it. overshoot_us is the
+* mean time each sleep ran past SLEEP_MS: one tick from the rounding in
+* k_sleep, plus whatever the ticks cost.
+*
+* Output is one line per run:
+*   BENCH bench=timers mode=arm timers=<n> ops=<n> total_us=<n> ns_per_op=<n>
+*   BENCH bench=timers mode=sleep timers=<n> sleeps=<n> sleep_ms=<n> total_us=<n> ns_per_op=<n> overshoot_us=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int timerCounts[] = { 0, OUTSTANDING_TIMERS };
+    DWORD startTime, endTime;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Run 1: arm and disarm with OUTSTANDING_TIMERS armed --- */
+    for (int i = 0; i < OUTSTANDING_TIMERS; i++)
+    {
+        timerIds[i] = periodic_timer_start(20 + i * 20);
+    }
+
+    startTime = read_clock();
+    for (int i = 0; i < ARM_OPS; i++)
+    {
+        int id = periodic_timer_start(20 + (i % OUTSTANDING_TIMERS) * 20);
+        periodic_timer_stop(id);
+    }
+    endTime = read_clock();
+
+    console_output(FALSE, "BENCH bench=timers mode=arm timers=%d ops=%d total_us=%u ns_per_op=%u\n",
+        OUTSTANDING_TIMERS, ARM_OPS, endTime - startTime,
+        (unsigned)(((endTime - startTime) * 1000ULL) / ARM_OPS));
+
+    for (int i = 0; i < OUTSTANDING_TIMERS; i++)
+    {
+        periodic_timer_stop(timerIds[i]);
+    }
+
+    /* --- Run 2: k_sleep with and without OUTSTANDING_TIMERS running --- */
+    for (int run = 0; run < sizeof(timerCounts) / sizeof(timerCounts[0]); run++)
+    {
+        for (int i = 0; i < timerCounts[run]; i++)
+        {
+            timerIds[i] = periodic_timer_start(20 + i * 20);
+        }
+
+        startTime = read_clock();
+        for (int i = 0; i < SLEEP_COUNT; i++)
+        {
+            k_sleep(SLEEP_MS);
+        }
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=timers mode=sleep timers=%d sleeps=%d sleep_ms=%d total_us=%u ns_per_op=%u overshoot_us=%u\n",
+            timerCounts[run], SLEEP_COUNT, SLEEP_MS, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / SLEEP_COUNT),
+            (unsigned)((endTime - startTime) / SLEEP_COUNT - SLEEP_MS * 1000));
+
+        for (int i = 0; i < timerCounts[run]; i++)
+        {
+            periodic_timer_stop(timerIds[i]);
+        }
+    }
+
+    k_exit(0);
+    return 0;
+}
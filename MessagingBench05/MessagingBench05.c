@@ -0,0 +1,82 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define BULK_DEPTH      1000
+#define ROUNDS          200
+#define CONTROL_LANE    (MESSAGE_LANES - 1)
+
+/*********************************************************************************
+*
+* MessagingBench05 - Control Message Latency Behind Bulk Traffic
+*
+* A mailbox holds BULK_DEPTH queued bulk messages. Each round sends one
+* control message and receives until the control message comes out. Every
+* bulk message received on the way is sent again, so the backlog stays at
+* BULK_DEPTH for the next round.
+*
+* In mode=fifo the control message is sent with mailbox_send and waits behind
+* the whole backlog. In mode=lane it is sent with mailbox_send_prio on the
+* highest lane and is received next. ns_per_op is the mean time from sending
+* the control message to receiving it; ahead is the mean number of bulk
+* messages received before it.
+*
+* Output is one line per mode:
+*   BENCH bench=lanes mode=<fifo|lane> depth=<n> rounds=<n> total_us=<n> ns_per_op=<n> ahead=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char bulk[32] = "bulk";
+    char control[32] = "control";
+    char message[32];
+    int mailboxId;
+    long long ahead;
+    DWORD startTime, endTime;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        mailboxId = mailbox_create(BULK_DEPTH + 1, sizeof(message));
+        for (int i = 0; i < BULK_DEPTH; i++)
+        {
+            mailbox_send(mailboxId, bulk, sizeof(bulk), FALSE);
+        }
+
+        ahead = 0;
+        startTime = read_clock();
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            if (mode == 0)
+                mailbox_send(mailboxId, control, sizeof(control), FALSE);
+            else
+                mailbox_send_prio(mailboxId, control, sizeof(control), CONTROL_LANE, FALSE);
+
+            while (1)
+            {
+                mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+                if (strcmp(message, control) == 0)
+                    break;
+                mailbox_send(mailboxId, bulk, sizeof(bulk), FALSE);
+                ahead++;
+            }
+        }
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=lanes mode=%s depth=%d rounds=%d total_us=%u ns_per_op=%u ahead=%u\n",
+            mode == 0 ? "fifo" : "lane", BULK_DEPTH, ROUNDS, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / ROUNDS),
+            (unsigned)(ahead / ROUNDS));
+
+        mailbox_free(mailboxId);
+    }
+
+    k_exit(0);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define MAX_SUBSCRIBERS 256
+#define BURST           8
+#define ROUNDS          500
+
+int mailboxIds[MAX_SUBSCRIBERS];
+
+/*********************************************************************************
+*
+* MessagingBench06 - Fan-Out Cost by Subscriber Count
+*
+* One event of MAX_MESSAGE bytes goes to N subscribers, N = 1, 8, 64 and
+* 256. In mode=fanout the sender copies it into N plain mailboxes, one
+* mailbox_send each. In mode=multicast it does one mailbox_send to a
+* multicast mailbox with N subscriptions.
+*
+* Each round sends BURST events and then every subscriber receives them.
+* Only the sends are timed: ns_per_op is the cost of getting one event to
+* all N subscribers. slots_peak is the most pool slots held at once, which
+* for multicast includes the spare slot.
+*
+* Output is one line per mode and subscriber count:
+*   BENCH bench=multicast mode=<fanout|multicast> subscribers=<n> events=<n> total_us=<n> ns_per_op=<n> slots_peak=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int subscriberCounts[] = { 1, 8, 64, MAX_SUBSCRIBERS };
+    char event[MAX_MESSAGE];
+    char message[MAX_MESSAGE];
+    mailbox_usage_t usage;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    memset(event, 'x', sizeof(event));
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        for (int run = 0; run < sizeof(subscriberCounts) / sizeof(subscriberCounts[0]); run++)
+        {
+            int subscribers = subscriberCounts[run];
+            int multicastId = -1;
+            int slotsPeak = 0;
+            DWORD sendTime = 0;
+
+            if (mode == 1)
+                multicastId = mailbox_create_multicast(BURST, MAX_MESSAGE);
+            for (int i = 0; i < subscribers; i++)
+            {
+                mailboxIds[i] = mode == 0 ? mailbox_create(BURST, MAX_MESSAGE) : mailbox_subscribe(multicastId);
+            }
+
+            for (int round = 0; round < ROUNDS; round++)
+            {
+                DWORD startTime = read_clock();
+                for (int e = 0; e < BURST; e++)
+                {
+                    if (mode == 0)
+                    {
+                        for (int i = 0; i < subscribers; i++)
+                            mailbox_send(mailboxIds[i], event, sizeof(event), FALSE);
+                    }
+                    else
+                    {
+                        mailbox_send(multicastId, event, sizeof(event), FALSE);
+                    }
+                }
+                sendTime += read_clock() - startTime;
+
+                for (int i = 0; i < subscribers; i++)
+                {
+                    for (int e = 0; e < BURST; e++)
+                        mailbox_receive(mailboxIds[i], message, sizeof(message), FALSE);
+                }
+            }
+
+            if (mode == 0)
+            {
+                for (int i = 0; i < subscribers; i++)
+                {
+                    mailbox_get_usage(mailboxIds[i], &usage);
+                    slotsPeak += usage.slotsPeak;
+                }
+            }
+            else
+            {
+                mailbox_get_usage(multicastId, &usage);
+                slotsPeak = usage.slotsPeak;
+            }
+
+            console_output(FALSE, "BENCH bench=multicast mode=%s subscribers=%d events=%d total_us=%u ns_per_op=%u slots_peak=%d\n",
+                mode == 0 ? "fanout" : "multicast", subscribers, ROUNDS * BURST, sendTime,
+                (unsigned)((sendTime * 1000ULL) / (ROUNDS * BURST)), slotsPeak);
+
+            for (int i = 0; i < subscribers; i++)
+            {
+                mailbox_free(mailboxIds[i]);
+            }
+            if (mode == 1)
+                mailbox_free(multicastId);
+        }
+    }
+
+    k_exit(0);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TERMINALS       4
+#define DEPTH           15      /* events a device ring holds without coalescing */
+#define ROUNDS          100
+
+/*********************************************************************************
+*
+* MessagingBench07 - wait_device Loop Overhead
+*
+* Each round starts DEPTH writes on each of the four terminals and sleeps
+* until they have all completed, so every wait returns at once with an
+* event already queued. The timed part is the wait loop alone: DEPTH waits
+* per terminal.
+*
+* In mode=name each wait is wait_device(name). In mode=handle the handles
+* come from wait_device_open before the loop and each wait is
+* wait_device_h(handle). ns_per_op is the mean cost of one wait.
+*
+* Output is one line per mode:
+*   BENCH bench=wait_device mode=<name|handle> waits=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char* terminals[TERMINALS] = { "term0", "term1", "term2", "term3" };
+    int handles[TERMINALS];
+    device_control_block_t controlBlock;
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)'.';
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        DWORD waitTime = 0;
+
+        for (int t = 0; t < TERMINALS; t++)
+        {
+            handles[t] = wait_device_open(terminals[t]);
+        }
+
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            for (int t = 0; t < TERMINALS; t++)
+            {
+                for (int i = 0; i < DEPTH; i++)
+                    device_control(terminals[t], controlBlock);
+            }
+            k_sleep(DEPTH + 5);
+
+            DWORD startTime = read_clock();
+            for (int t = 0; t < TERMINALS; t++)
+            {
+                for (int i = 0; i < DEPTH; i++)
+                {
+                    if (mode == 0)
+                        wait_device(terminals[t], &status);
+                    else
+                        wait_device_h(handles[t], &status);
+                }
+            }
+            waitTime += read_clock() - startTime;
+        }
+
+        console_output(FALSE, "BENCH bench=wait_device mode=%s waits=%d total_us=%u ns_per_op=%u\n",
+            mode == 0 ? "name" : "handle", ROUNDS * TERMINALS * DEPTH, waitTime,
+            (unsigned)((waitTime * 1000ULL) / (ROUNDS * TERMINALS * DEPTH)));
+    }
+
+    k_exit(0);
+    return 0;
+}
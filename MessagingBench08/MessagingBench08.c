@@ -0,0 +1,87 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define ROUND_TRIPS     100000
+
+int UserRoundTrips(char* strArgs);
+
+int mailboxId;
+DWORD elapsed;
+
+/*********************************************************************************
+*
+* MessagingBench08 - System Call Round Trip
+*
+* A round trip is one non-blocking send of a 16-byte message to an empty
+* mailbox and one receive of it. In mode=kernel a kernel-mode process calls
+* mailbox_send and mailbox_receive. In mode=syscall a user-mode child calls
+* sys_mailbox_send and sys_mailbox_receive, so every call also goes through
+* system_call and the systemCallVector. ns_per_op is the mean cost of one
+* round trip, two calls.
+*
+* Output is one line per mode:
+*   BENCH bench=syscall mode=<kernel|syscall> round_trips=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char message[16] = "round trip";
+    DWORD startTime;
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    mailboxId = mailbox_create(1, sizeof(message));
+
+    startTime = read_clock();
+    for (int i = 0; i < ROUND_TRIPS; i++)
+    {
+        mailbox_send(mailboxId, message, sizeof(message), FALSE);
+        mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    }
+    elapsed = read_clock() - startTime;
+    console_output(FALSE, "BENCH bench=syscall mode=kernel round_trips=%d total_us=%u ns_per_op=%u\n",
+        ROUND_TRIPS, elapsed, (unsigned)((elapsed * 1000ULL) / ROUND_TRIPS));
+
+    k_spawn("UserRoundTrips", UserRoundTrips, NULL, THREADS_MIN_STACK_SIZE, 4);
+    k_wait(&status);
+    console_output(FALSE, "BENCH bench=syscall mode=syscall round_trips=%d total_us=%u ns_per_op=%u\n",
+        ROUND_TRIPS, elapsed, (unsigned)((elapsed * 1000ULL) / ROUND_TRIPS));
+
+    mailbox_free(mailboxId);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* UserRoundTrips
+*
+* The round trip loop in user mode, through the system call stubs.
+*********************************************************************************/
+int UserRoundTrips(char* strArgs)
+{
+    char message[16] = "round trip";
+    DWORD startTime;
+
+    set_psr(get_psr() & ~PSR_KERNEL_MODE);
+
+    startTime = read_clock();
+    for (int i = 0; i < ROUND_TRIPS; i++)
+    {
+        sys_mailbox_send(mailboxId, message, sizeof(message), FALSE);
+        sys_mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    }
+    elapsed = read_clock() - startTime;
+
+    /* There is no exit system call, so go back to kernel mode to k_exit */
+    set_psr(get_psr() | PSR_KERNEL_MODE);
+    k_exit(0);
+    return 0;
+}
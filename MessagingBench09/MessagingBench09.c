@@ -0,0 +1,88 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TOTAL_MESSAGES  40000
+#define MESSAGE_SIZE    16
+
+int Consumer(char* strArgs);
+
+int mailboxId;
+
+/*********************************************************************************
+*
+* MessagingBench09 - One-Way Throughput by Mailbox Depth
+*
+* A producer (the parent) sends TOTAL_MESSAGES 16-byte messages with
+* mailbox_send to a consumer child of the same priority, which takes them
+* with mailbox_receive. Both sides block when the mailbox is full or empty.
+*
+* The run is repeated with 1, 8 and 64 slots. With one slot nearly every
+* message blocks one side and wakes the other; with more slots each side
+* runs further before it has to switch.
+*
+* Output is one line per run:
+*   BENCH bench=throughput slots=<n> messages=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int slotCounts[] = { 1, 8, 64 };
+    char message[MESSAGE_SIZE];
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    memset(message, 'x', sizeof(message));
+
+    for (int run = 0; run < sizeof(slotCounts) / sizeof(slotCounts[0]); run++)
+    {
+        DWORD startTime, endTime;
+
+        mailboxId = mailbox_create(slotCounts[run], MESSAGE_SIZE);
+
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Consumer", testName);
+        k_spawn(nameBuffer, Consumer, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+
+        startTime = read_clock();
+        for (int i = 0; i < TOTAL_MESSAGES; i++)
+        {
+            mailbox_send(mailboxId, message, MESSAGE_SIZE, TRUE);
+        }
+        k_wait(&status);
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=throughput slots=%d messages=%d total_us=%u ns_per_op=%u\n",
+            slotCounts[run], TOTAL_MESSAGES, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / TOTAL_MESSAGES));
+
+        mailbox_free(mailboxId);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* Consumer
+*
+* Receives TOTAL_MESSAGES messages.
+*********************************************************************************/
+int Consumer(char* strArgs)
+{
+    char message[MESSAGE_SIZE];
+
+    for (int i = 0; i < TOTAL_MESSAGES; i++)
+    {
+        mailbox_receive(mailboxId, message, MESSAGE_SIZE, TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
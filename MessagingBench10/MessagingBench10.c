@@ -0,0 +1,121 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TOTAL_MESSAGES  48000   /* divides evenly among 1, 2, 4 or 8 processes */
+#define MAILBOX_SLOTS   16
+#define MESSAGE_SIZE    16
+
+int Producer(char* strArgs);
+int Consumer(char* strArgs);
+
+int mailboxId;
+int perProducer;
+int perConsumer;
+
+/*********************************************************************************
+*
+* MessagingBench10 - Producers and Consumers
+*
+* N producer children send TOTAL_MESSAGES 16-byte messages, split evenly,
+* into one 16-slot mailbox, and M consumer children receive them, also
+* split evenly. All children run at priority 4, so none starts until the
+* parent blocks in k_wait; the time is from then until the last child has
+* exited.
+*
+* The run is repeated for 1x1, 2x2, 4x4, 8x8, 4x1 and 1x4. More processes on
+* each side mean longer wait queues and more wakes that find the mailbox
+* already served.
+*
+* Output is one line per run:
+*   BENCH bench=mpmc producers=<n> consumers=<n> messages=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int shapes[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 8, 8 }, { 4, 1 }, { 1, 4 } };
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int run = 0; run < sizeof(shapes) / sizeof(shapes[0]); run++)
+    {
+        int producers = shapes[run][0];
+        int consumers = shapes[run][1];
+        DWORD startTime, endTime;
+
+        mailboxId = mailbox_create(MAILBOX_SLOTS, MESSAGE_SIZE);
+        perProducer = TOTAL_MESSAGES / producers;
+        perConsumer = TOTAL_MESSAGES / consumers;
+
+        for (int i = 0; i < consumers; i++)
+        {
+            snprintf(nameBuffer, sizeof(nameBuffer), "%s-Consumer%d", testName, i);
+            k_spawn(nameBuffer, Consumer, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        }
+        for (int i = 0; i < producers; i++)
+        {
+            snprintf(nameBuffer, sizeof(nameBuffer), "%s-Producer%d", testName, i);
+            k_spawn(nameBuffer, Producer, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        }
+
+        startTime = read_clock();
+        for (int i = 0; i < producers + consumers; i++)
+        {
+            k_wait(&status);
+        }
+        endTime = read_clock();
+
+        console_output(FALSE, "BENCH bench=mpmc producers=%d consumers=%d messages=%d total_us=%u ns_per_op=%u\n",
+            producers, consumers, TOTAL_MESSAGES, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / TOTAL_MESSAGES));
+
+        mailbox_free(mailboxId);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* Producer
+*
+* Sends its share of the messages.
+*********************************************************************************/
+int Producer(char* strArgs)
+{
+    char message[MESSAGE_SIZE];
+
+    memset(message, 'x', sizeof(message));
+    for (int i = 0; i < perProducer; i++)
+    {
+        mailbox_send(mailboxId, message, MESSAGE_SIZE, TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* Consumer
+*
+* Receives its share of the messages.
+*********************************************************************************/
+int Consumer(char* strArgs)
+{
+    char message[MESSAGE_SIZE];
+
+    for (int i = 0; i < perConsumer; i++)
+    {
+        mailbox_receive(mailboxId, message, MESSAGE_SIZE, TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TOTAL_MESSAGES  40000
+#define MAILBOX_SLOTS   8
+#define MESSAGE_SIZE    16
+
+int OneWayConsumer(char* strArgs);
+int EchoProcess(char* strArgs);
+
+int mailboxPing;
+int mailboxPong;
+int messageSize;
+
+/*********************************************************************************
+*
+* MessagingBench11 - Zero-Length Signals
+*
+* Compares zero-length messages, used as signals, with 16-byte messages in
+* two patterns, each between the parent and a child of the same priority:
+*
+*   one_way   - TOTAL_MESSAGES sends into an 8-slot mailbox that the child
+*               drains. ns_per_op is per message.
+*   ping_pong - TOTAL_MESSAGES round trips over two zero-slot mailboxes, the
+*               child echoing each message. ns_per_op is per round trip.
+*
+* The difference between size=0 and size=16 is the cost of the copies; the
+* rest is the signalling itself.
+*
+* Output is one line per run:
+*   BENCH bench=signal pattern=<one_way|ping_pong> size=<0|16> messages=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int sizes[] = { 0, MESSAGE_SIZE };
+    char message[MESSAGE_SIZE];
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    memset(message, 'x', sizeof(message));
+
+    for (int pattern = 0; pattern < 2; pattern++)
+    {
+        for (int run = 0; run < sizeof(sizes) / sizeof(sizes[0]); run++)
+        {
+            DWORD startTime, endTime;
+
+            messageSize = sizes[run];
+            if (pattern == 0)
+            {
+                mailboxPing = mailbox_create(MAILBOX_SLOTS, MESSAGE_SIZE);
+                snprintf(nameBuffer, sizeof(nameBuffer), "%s-Consumer", testName);
+                k_spawn(nameBuffer, OneWayConsumer, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+            }
+            else
+            {
+                mailboxPing = mailbox_create(0, MESSAGE_SIZE);
+                mailboxPong = mailbox_create(0, MESSAGE_SIZE);
+                snprintf(nameBuffer, sizeof(nameBuffer), "%s-Echo", testName);
+                k_spawn(nameBuffer, EchoProcess, nameBuffer, THREADS_MIN_STACK_SIZE, 5);
+            }
+
+            startTime = read_clock();
+            for (int i = 0; i < TOTAL_MESSAGES; i++)
+            {
+                mailbox_send(mailboxPing, message, messageSize, TRUE);
+                if (pattern == 1)
+                    mailbox_receive(mailboxPong, message, MESSAGE_SIZE, TRUE);
+            }
+            k_wait(&status);
+            endTime = read_clock();
+
+            console_output(FALSE, "BENCH bench=signal pattern=%s size=%d messages=%d total_us=%u ns_per_op=%u\n",
+                pattern == 0 ? "one_way" : "ping_pong", messageSize, TOTAL_MESSAGES, endTime - startTime,
+                (unsigned)(((endTime - startTime) * 1000ULL) / TOTAL_MESSAGES));
+
+            mailbox_free(mailboxPing);
+            if (pattern == 1)
+                mailbox_free(mailboxPong);
+        }
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* OneWayConsumer
+*
+* Receives TOTAL_MESSAGES messages.
+*********************************************************************************/
+int OneWayConsumer(char* strArgs)
+{
+    char message[MESSAGE_SIZE];
+
+    for (int i = 0; i < TOTAL_MESSAGES; i++)
+    {
+        mailbox_receive(mailboxPing, message, MESSAGE_SIZE, TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* EchoProcess
+*
+* Receives each ping and sends it straight back on the pong mailbox.
+*********************************************************************************/
+int EchoProcess(char* strArgs)
+{
+    char message[MESSAGE_SIZE];
+
+    for (int i = 0; i < TOTAL_MESSAGES; i++)
+    {
+        int size = mailbox_receive(mailboxPing, message, MESSAGE_SIZE, TRUE);
+        mailbox_send(mailboxPong, message, size, TRUE);
+    }
+
+    k_exit(0);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TERMINALS       4
+#define WAITS           200     /* writes waited for by each waiter */
+
+int TerminalWaiter(char* strArgs);
+
+/* per-waiter timing, indexed by terminal */
+DWORD totalUs[TERMINALS];
+DWORD minUs[TERMINALS];
+DWORD maxUs[TERMINALS];
+
+/*********************************************************************************
+*
+* MessagingBench12 - Device Wakeup Latency
+*
+* Each waiter writes one character to its terminal and blocks in
+* wait_device until the write completes, WAITS times. The time of each wait
+* runs from just before device_control to just after wait_device returns,
+* so it is the device's own time plus the interrupt, the event ring and the
+* wake. The device time is the same on every wait; the spread between
+* min_us and the mean or max_us is what the wakeup path adds.
+*
+* The run is done with one waiter on term0, then with four children, one
+* per terminal, whose interrupts and wakes interleave.
+*
+* Output is one line per run:
+*   BENCH bench=device_wake waiters=<1|4> waits=<n> total_us=<n> ns_per_op=<n> min_us=<n> max_us=<n>
+*
+* total_us is the sum of the waits and ns_per_op their mean.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    int status;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int waiters = 1; waiters <= TERMINALS; waiters += TERMINALS - 1)
+    {
+        DWORD total = 0, minimum = 0xFFFFFFFF, maximum = 0;
+
+        for (int t = 0; t < waiters; t++)
+        {
+            snprintf(nameBuffer, sizeof(nameBuffer), "term%d", t);
+            k_spawn(nameBuffer, TerminalWaiter, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        }
+        for (int t = 0; t < waiters; t++)
+        {
+            k_wait(&status);
+        }
+
+        for (int t = 0; t < waiters; t++)
+        {
+            total += totalUs[t];
+            if (minUs[t] < minimum)
+                minimum = minUs[t];
+            if (maxUs[t] > maximum)
+                maximum = maxUs[t];
+        }
+
+        console_output(FALSE, "BENCH bench=device_wake waiters=%d waits=%d total_us=%u ns_per_op=%u min_us=%u max_us=%u\n",
+            waiters, waiters * WAITS, total, (unsigned)((total * 1000ULL) / (waiters * WAITS)), minimum, maximum);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* TerminalWaiter
+*
+* Times WAITS write-and-wait rounds on the terminal it is named after.
+*********************************************************************************/
+int TerminalWaiter(char* strArgs)
+{
+    device_control_block_t controlBlock;
+    int t = strArgs[4] - '0';
+    int status;
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)'.';
+
+    totalUs[t] = 0;
+    minUs[t] = 0xFFFFFFFF;
+    maxUs[t] = 0;
+
+    for (int i = 0; i < WAITS; i++)
+    {
+        DWORD startTime = read_clock();
+        device_control(strArgs, controlBlock);
+        wait_device(strArgs, &status);
+        DWORD elapsed = read_clock() - startTime;
+
+        totalUs[t] += elapsed;
+        if (elapsed < minUs[t])
+            minUs[t] = elapsed;
+        if (elapsed > maxUs[t])
+            maxUs[t] = elapsed;
+    }
+
+    k_exit(0);
+    return 0;
+}
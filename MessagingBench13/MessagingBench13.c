@@ -0,0 +1,57 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define EVENTS  1000000
+
+/* Internal to the messaging layer; declared here so one record can be timed on its own. */
+void trace_event(int event, int pid, int mboxId, int size);
+
+/*********************************************************************************
+*
+* MessagingBench13 - Cost of One Trace Record
+*
+* Times EVENTS calls of trace_event, the function every traced mailbox
+* operation goes through, with interrupts disabled as its callers have them.
+* For scale, the same number of read_clock calls is timed as well.
+*
+* Output is one line per mode:
+*   BENCH bench=trace mode=<trace_event|read_clock> calls=<n> total_us=<n> ns_per_op=<n>
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    volatile DWORD sink = 0;
+    DWORD startTime, endTime;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        disableInterrupts();
+        startTime = read_clock();
+        for (int i = 0; i < EVENTS; i++)
+        {
+            if (mode == 0)
+                trace_event(MAILBOX_TRACE_SEND, 1, i, 16);
+            else
+                sink += read_clock();
+        }
+        endTime = read_clock();
+        enableInterrupts();
+
+        console_output(FALSE, "BENCH bench=trace mode=%s calls=%d total_us=%u ns_per_op=%u\n",
+            mode == 0 ? "trace_event" : "read_clock", EVENTS, endTime - startTime,
+            (unsigned)(((endTime - startTime) * 1000ULL) / EVENTS));
+    }
+
+    mailbox_trace_reset();
+
+    k_exit(0);
+    return 0;
+}
@@ -13,137 +13,590 @@
 #include <Scheduler.h>
 #include <Messaging.h>
 #include <stdint.h>
+#include <stddef.h>
 #include "message.h"
 #include "MessagingHelpers.h"
 
 //////////// USER GLOBAL VARIABLES ////////////
-SlotPtr freeSlotHead = NULL;                 // Slot free list management   TEST02 ADD
 int g_mailbox_maxSlots[MAXMBOX];             // TEST03 ADD
+int g_mailbox_slotClass[MAXMBOX];            // PERF ADD slot size class picked by mailbox_create
+int g_mailbox_slotReserve[MAXMBOX];          // PERF ADD slots guaranteed to the mailbox, 0 if none
+int g_mailbox_slotQuota[MAXMBOX];            // PERF ADD most slots the mailbox may hold, 0 if no quota
+int g_mailbox_slotsUsed[MAXMBOX];            // PERF ADD slots charged to the mailbox right now
+int g_mailbox_slotsPeak[MAXMBOX];            // PERF ADD high-water mark of g_mailbox_slotsUsed
+int g_mailbox_quotaRejects[MAXMBOX];         // PERF ADD sends turned away by the quota
+mailbox_stats_t g_mailbox_stats[MAXMBOX];    // PERF ADD traffic counters, depth is filled in on read
+mailbox_latency_t g_mailbox_latency[MAXMBOX];    // PERF ADD blocking-time histograms, percentiles are filled in on read
+mailbox_trace_record_t g_traceRing[TRACE_RING_RECORDS];     // PERF ADD event trace, oldest records overwritten
+uint32_t g_traceNext = 0;                    // PERF ADD records ever written to g_traceRing
+mailbox_trace_record_t g_traceCopy[TRACE_RING_RECORDS];     // PERF ADD the ring, oldest first, as a dump writes it
+int g_traceDumping = 0;                      // PERF ADD a dump is writing g_traceCopy
+uint32_t g_traceStartClock;                  // PERF ADD read_clock() when the trace was started or reset
+uint64_t g_traceStartStamp;                  // PERF ADD TRACE_STAMP() at the same moment
+SlotPtr g_mailbox_stash[MAXMBOX];            // PERF ADD reserved slots not in use right now
+int g_mailbox_stashCount[MAXMBOX];           // PERF ADD length of g_mailbox_stash
+const int g_slotClassSize[SLOT_CLASS_COUNT] = { 16, 64, MAX_MESSAGE };    // PERF ADD payload bytes per class
+SlabPage g_slabPages[SLAB_PAGES];            // PERF ADD per-page slab bookkeeping
+int g_slabPartial[SLOT_CLASS_COUNT];         // PERF ADD pages of each class with a free slot, -1 if none
+int g_slabFreePage = -1;                     // PERF ADD head of the free page pool, -1 if empty
+int g_slabFreePageCount = 0;                 // PERF ADD pages in the free page pool
+int g_slabClassFree[SLOT_CLASS_COUNT];       // PERF ADD free slots in the pages of each class
+WaitingProcessPtr g_poolWaitHead = NULL;     // PERF ADD senders waiting for the shared slot pool
+WaitingProcessPtr g_poolWaitTail = NULL;     // PERF ADD
+int g_poolWoken[SLOT_CLASS_COUNT];           // PERF ADD pool waiters woken that have not retried yet
+int g_clockTicks = 0;                        // PERF ADD clock interrupts seen by the messaging layer
+int g_timerWheel[TIMER_WHEEL_BUCKETS];       // PERF ADD first timer node in each bucket, -1 if none
+TimerNode g_timerNode[TIMER_NODES];          // PERF ADD wheel links of every timer
+int g_timersArmed = 0;                       // PERF ADD number of armed timers
+PeriodicTimer g_periodicTimer[MAX_PERIODIC_TIMERS];     // PERF ADD
+int g_freeTimerStack[MAX_PERIODIC_TIMERS];   // PERF ADD free periodic timer indexes
+int g_freeTimerCount = 0;                    // PERF ADD number of free periodic timer indexes
+MailboxRing g_mailboxRing[MAXMBOX];          // PERF ADD ring storage of each mailbox
+unsigned char g_ringArena[RING_ARENA_SIZE];  // PERF ADD backing store of ring mailboxes
+int g_ringFirst = -1;                        // PERF ADD ring mailbox with the lowest offset, -1 if none
+MailboxMulticast g_mailboxMcast[MAXMBOX];    // PERF ADD multicast mailboxes and their subscriptions
 MsgProcEntry g_msgProc[MAXPROC];             // TEST05 ADD One waiting node per process
 WaitingProcess g_waitNode[MAXPROC];          // TEST05 ADD
+WaitingProcess g_anyNode[MAXPROC][MAX_RECEIVE_ANY];  // PERF ADD one receive queue node per mailbox of a mailbox_receive_any call
 WaitingProcessPtr g_waitRecvHead[MAXMBOX];   // TEST05 ADD mailbox wait queues receiver head
 WaitingProcessPtr g_waitRecvTail[MAXMBOX];   // TEST05 ADD mailbox wait queues receiver tail
 WaitingProcessPtr g_waitSendHead[MAXMBOX];   // TEST05 ADD mailbox wait queues sender head
 WaitingProcessPtr g_waitSendTail[MAXMBOX];   // TEST05 ADD mailbox wait queues sender tail
 SlotPtr g_slotTail[MAXMBOX];                 // TEST05 ADD mailbox slot tail for FIFO
+SlotPtr g_slotLaneTail[MAXMBOX][MESSAGE_LANES];  // PERF ADD last queued slot of each lane
+int g_mailbox_wakePolicy[MAXMBOX];           // PERF ADD MBOX_WAKE_FIFO or MBOX_WAKE_PRIORITY
+WaitingProcessPtr g_waitRecvLevelTail[MAXMBOX][WAKE_LEVELS];    // PERF ADD last receiver of each wake priority
+WaitingProcessPtr g_waitSendLevelTail[MAXMBOX][WAKE_LEVELS];    // PERF ADD last sender of each wake priority
+int g_wakePriorityPid[MAXPROC];              // PERF ADD pid that set the wake priority, by pid bucket
+int g_wakePriority[MAXPROC];                 // PERF ADD wake priority set by that pid
+int g_freeMboxQueue[MAXMBOX];                // PERF ADD free mailbox index ring (FIFO)
+int g_freeMboxHead = 0;                      // PERF ADD next index handed out by mailbox_create
+int g_freeMboxCount = 0;                     // PERF ADD number of free mailbox indexes
+int g_pidBucket[MAXPROC];                    // PERF ADD pid hash buckets, head entry index or -1
+int g_freeProcStack[MAXPROC];                // PERF ADD free MsgProcEntry indexes
+int g_freeProcCount = 0;                     // PERF ADD number of free MsgProcEntry indexes
 ///////////////////////////////////////////////
 
-static int mpIndex(int pid);                // TEST05 ADD
+static void mp_reset(int idx, int pid);     // PERF ADD
+static int mp_lookup(int pid);              // PERF ADD
+static void latency_stop(MsgProcEntry* me); // PERF ADD
+static unsigned int latency_percentile(const mailbox_latency_t* lat, int pct);  // PERF ADD
 
-static int mpIndex(int pid)
+static void mp_reset(int idx, int pid)
 {
-    // TEST09 ADD DO NOT use pid % MAXPROC (pid collisions kill the wrong process)
+    g_msgProc[idx].pid = pid;
+    g_msgProc[idx].recvBuf = NULL;
+    g_msgProc[idx].recvMax = 0;
+    g_msgProc[idx].recvResult = -9999;
+    g_msgProc[idx].sendBuf = NULL;
+    g_msgProc[idx].sendSize = 0;
+    g_msgProc[idx].sendResult = -9999;
+    g_msgProc[idx].sendLane = 0;
+    g_msgProc[idx].blockedMbox = -1;
+    g_msgProc[idx].blockedType = 0;
+    g_msgProc[idx].hashNext = -1;
+    g_msgProc[idx].inPlace = 0;
+    g_msgProc[idx].inPlaceSlot = NULL;
+    g_msgProc[idx].poolClass = -1;
+    g_msgProc[idx].poolWoken = 0;
+    g_msgProc[idx].anyCount = 0;
+    g_msgProc[idx].anyWhich = -1;
+    g_msgProc[idx].timedOut = 0;
+    g_msgProc[idx].blockTimed = 0;                  // PERF ADD
 
-    // 1) If PID already has a slot, return it
-    for (int i = 0; i < MAXPROC; i++)
+    g_waitNode[idx].pid = pid;
+    g_waitNode[idx].pNextProcess = NULL;
+    g_waitNode[idx].pPrevProcess = NULL;
+    g_waitNode[idx].pLevelTails = NULL;             // PERF ADD
+}
+
+// PERF ADD Find the entry attached to pid. Buckets are chained, so two live pids
+// that hash alike (TEST09: pid % MAXPROC collisions) each keep their own entry.
+static int mp_lookup(int pid)
+{
+    if (pid < 0)
+        return -1;
+
+    for (int i = g_pidBucket[MP_BUCKET(pid)]; i >= 0; i = g_msgProc[i].hashNext)
     {
         if (g_msgProc[i].pid == pid)
             return i;
     }
+    return -1;
+}
 
-    // 2) Otherwise allocate a free slot
+void init_proc_table(void)
+{
     for (int i = 0; i < MAXPROC; i++)
     {
-        if (g_msgProc[i].pid == -1)
-        {
-            g_msgProc[i].pid = pid;
+        mp_reset(i, -1);
+        g_pidBucket[i] = -1;
+        g_wakePriorityPid[i] = -1;                  // PERF ADD
+        g_freeProcStack[i] = MAXPROC - 1 - i;       // PERF ADD entry 0 is handed out first
+    }
+    g_freeProcCount = MAXPROC;
 
-            // Initialize process messaging state
-            g_msgProc[i].recvBuf = NULL;
-            g_msgProc[i].recvMax = 0;
-            g_msgProc[i].recvResult = -9999;
+    for (int b = 0; b < TIMER_WHEEL_BUCKETS; b++)   // PERF ADD
+    {
+        g_timerWheel[b] = -1;
+    }
+    for (int n = 0; n < TIMER_NODES; n++)           // PERF ADD
+    {
+        g_timerNode[n].bucket = -1;
+        g_timerNode[n].next = g_timerNode[n].prev = -1;
+    }
+    for (int t = 0; t < MAX_PERIODIC_TIMERS; t++)   // PERF ADD
+    {
+        g_periodicTimer[t].inUse = 0;
+        g_periodicTimer[t].waiter = -1;
+        g_freeTimerStack[t] = MAX_PERIODIC_TIMERS - 1 - t;
+    }
+    g_freeTimerCount = MAX_PERIODIC_TIMERS;
+    g_timersArmed = 0;
+    g_clockTicks = 0;
+    g_traceStartClock = read_clock();           // PERF ADD
+    g_traceStartStamp = TRACE_STAMP();          // PERF ADD
+}
 
-            g_msgProc[i].sendBuf = NULL;
-            g_msgProc[i].sendSize = 0;
-            g_msgProc[i].sendResult = -9999;
+static void slab_partial_push(int slotClass, int page);      // PERF ADD
+static void slab_partial_remove(int slotClass, int page);    // PERF ADD
+static SlotPtr slab_alloc(int slotClass);                    // PERF ADD
+static void slot_stash_push(int mboxIndex, SlotPtr s);       // PERF ADD
+static void slab_free(SlotPtr _slotptr);                     // PERF ADD
 
-            g_msgProc[i].blockedMbox = -1;
-            g_msgProc[i].blockedType = 0;
+static void slab_partial_push(int slotClass, int page)
+{
+    g_slabPages[page].prev = -1;
+    g_slabPages[page].next = g_slabPartial[slotClass];
+    if (g_slabPartial[slotClass] >= 0)
+        g_slabPages[g_slabPartial[slotClass]].prev = page;
+    g_slabPartial[slotClass] = page;
+}
 
-            // Also initialize wait node for safety
-            g_waitNode[i].pid = pid;
-            g_waitNode[i].pNextProcess = NULL;
-            g_waitNode[i].pPrevProcess = NULL;
+static void slab_partial_remove(int slotClass, int page)
+{
+    SlabPage* pg = &g_slabPages[page];
 
-            return i;
-        }
+    if (pg->prev >= 0) g_slabPages[pg->prev].next = pg->next;
+    else g_slabPartial[slotClass] = pg->next;
+    if (pg->next >= 0) g_slabPages[pg->next].prev = pg->prev;
+    pg->next = pg->prev = -1;
+}
+
+/* an error method to handle slot free list setup */
+/* PERF ALTER every slab page starts in the free page pool */
+void init_slot_freelist(void)
+{
+    for (int c = 0; c < SLOT_CLASS_COUNT; c++)
+    {
+        g_slabPartial[c] = -1;
+        g_slabClassFree[c] = 0;
+        g_poolWoken[c] = 0;
     }
 
-    // No room (shouldn't happen in these tests)
-    return -1;
+    g_poolWaitHead = NULL;
+    g_poolWaitTail = NULL;
+    g_slabFreePageCount = SLAB_PAGES;
+    g_slabFreePage = -1;
+    for (int p = SLAB_PAGES - 1; p >= 0; p--)
+    {
+        g_slabPages[p].slotClass = -1;
+        g_slabPages[p].inUse = 0;
+        g_slabPages[p].carved = 0;
+        g_slabPages[p].freeList = NULL;
+        g_slabPages[p].prev = -1;
+        g_slabPages[p].next = g_slabFreePage;
+        g_slabFreePage = p;
+    }
 }
 
-void init_proc_table(void)
+// PERF ADD Pick the smallest slot class whose payload holds slotSize bytes
+int slot_class_for_size(int slotSize)
 {
-    for (int i = 0; i < MAXPROC; i++)
+    for (int c = 0; c < SLOT_CLASS_MAX; c++)
+    {
+        if (slotSize <= g_slotClassSize[c])
+            return c;
+    }
+    return SLOT_CLASS_MAX;
+}
+
+// PERF ALTER take a slot of the given class from a partly used page, or start a fresh page
+static SlotPtr slab_alloc(int slotClass)
+{
+    int page = g_slabPartial[slotClass];
+    if (page < 0)
     {
-        g_msgProc[i].pid = -1;
-        g_msgProc[i].recvBuf = NULL;
-        g_msgProc[i].recvMax = 0;
-        g_msgProc[i].recvResult = -9999;
-        g_msgProc[i].sendBuf = NULL;
-        g_msgProc[i].sendSize = 0;
-        g_msgProc[i].sendResult = -9999;
-        g_msgProc[i].blockedMbox = -1;
-        g_msgProc[i].blockedType = 0;
+        page = g_slabFreePage;
+        if (page < 0)
+            return NULL;
 
-        g_waitNode[i].pid = -1;
-        g_waitNode[i].pNextProcess = NULL;
-        g_waitNode[i].pPrevProcess = NULL;
+        g_slabFreePage = g_slabPages[page].next;
+        g_slabFreePageCount--;
+        g_slabClassFree[slotClass] += SLOTS_PER_PAGE(g_slotClassSize[slotClass]);
+        g_slabPages[page].slotClass = slotClass;
+        g_slabPages[page].inUse = 0;
+        g_slabPages[page].carved = 0;
+        g_slabPages[page].freeList = NULL;
+        slab_partial_push(slotClass, page);
+    }
+
+    SlabPage* pg = &g_slabPages[page];
+    SlotPtr _slotptr = pg->freeList;
+    if (_slotptr != NULL)
+    {
+        pg->freeList = _slotptr->pNextSlot;
+    }
+    else
+    {
+        _slotptr = (SlotPtr)(mailSlotPages[page].bytes + pg->carved * SLOT_BYTES(g_slotClassSize[slotClass]));
+        pg->carved++;
     }
+
+    pg->inUse++;
+    g_slabClassFree[slotClass]--;
+    if (pg->inUse == SLOTS_PER_PAGE(g_slotClassSize[slotClass]))
+        slab_partial_remove(slotClass, page);
+
+    _slotptr->pNextSlot = NULL;
+    _slotptr->pPrevSlot = NULL;
+    _slotptr->mbox_id = -1;
+    _slotptr->messageSize = 0;
+    _slotptr->slotClass = slotClass;
+    _slotptr->slotState = SLOT_QUEUED;
+    return _slotptr;
 }
 
-/* an error method to handle slot free list setup */
-void init_slot_freelist(void)
+// PERF ALTER return the slot to its page; an empty page goes back to the shared pool
+static void slab_free(SlotPtr _slotptr)
 {
-    freeSlotHead = NULL;
-    for (int i = 0; i < MAXSLOTS; i++)
+    if (!_slotptr) return;
+
+    int page = (int)(((unsigned char*)_slotptr - mailSlotPages[0].bytes) / SLAB_PAGE_SIZE);
+    SlabPage* pg = &g_slabPages[page];
+    int slotClass = pg->slotClass;
+    int wasFull = (pg->inUse == SLOTS_PER_PAGE(g_slotClassSize[slotClass]));
+
+    _slotptr->pNextSlot = pg->freeList;
+    _slotptr->pPrevSlot = NULL;
+    _slotptr->mbox_id = -1;
+    _slotptr->messageSize = 0;
+    _slotptr->slotState = SLOT_FREE;
+    pg->freeList = _slotptr;
+    pg->inUse--;
+    g_slabClassFree[slotClass]++;
+
+    if (pg->inUse == 0)
+    {
+        if (!wasFull)
+            slab_partial_remove(slotClass, page);
+        g_slabClassFree[slotClass] -= SLOTS_PER_PAGE(g_slotClassSize[slotClass]);
+        pg->slotClass = -1;
+        pg->next = g_slabFreePage;
+        g_slabFreePage = page;
+        g_slabFreePageCount++;
+    }
+    else if (wasFull)
     {
-        mailSlots[i].pNextSlot = freeSlotHead;
-        mailSlots[i].pPrevSlot = NULL;
-        mailSlots[i].mbox_id = -1;
-        mailSlots[i].messageSize = 0;
-        freeSlotHead = &mailSlots[i];
+        slab_partial_push(slotClass, page);
     }
 }
 
 // allocate slot
-SlotPtr allocate_slot(void)
+// PERF ALTER charge the slot to a mailbox: its reserve stash is used first, and a
+// mailbox at its quota gets NULL even if the shared pool still has room
+SlotPtr allocate_slot(int mboxIndex)
 {
-    SlotPtr _slotptr = freeSlotHead;
+    if (slot_quota_full(mboxIndex))
+        return NULL;
+
+    SlotPtr _slotptr = g_mailbox_stash[mboxIndex];
     if (_slotptr != NULL)
     {
-        freeSlotHead = _slotptr->pNextSlot;
-        if (freeSlotHead) freeSlotHead->pPrevSlot = NULL;
-
+        g_mailbox_stash[mboxIndex] = _slotptr->pNextSlot;
+        g_mailbox_stashCount[mboxIndex]--;
         _slotptr->pNextSlot = NULL;
-        _slotptr->pPrevSlot = NULL;
-        _slotptr->mbox_id = -1;
-        _slotptr->messageSize = 0;
+        _slotptr->slotState = SLOT_QUEUED;
+    }
+    else
+    {
+        _slotptr = slab_alloc(g_mailbox_slotClass[mboxIndex]);
+        if (_slotptr == NULL)
+            return NULL;
     }
+
+    _slotptr->mbox_id = mailboxes[mboxIndex].mbox_id;
+    g_mailbox_slotsUsed[mboxIndex]++;
+    if (g_mailbox_slotsUsed[mboxIndex] > g_mailbox_slotsPeak[mboxIndex])
+        g_mailbox_slotsPeak[mboxIndex] = g_mailbox_slotsUsed[mboxIndex];
     return _slotptr;
 }
 
 // Free slot in list
-// Free slot in list
+// PERF ALTER uncharge the owning mailbox; the slot refills its reserve stash if that
+// is short, otherwise it goes back to the shared pool
 void free_slot(SlotPtr _slotptr)
 {
     if (!_slotptr) return;
 
-    /* Push onto free list head */
-    _slotptr->pNextSlot = freeSlotHead;
-    _slotptr->pPrevSlot = NULL;
+    int idx = mbox_index(_slotptr->mbox_id);
+    if (idx >= 0)
+    {
+        g_mailbox_slotsUsed[idx]--;
+        if (g_mailbox_slotsUsed[idx] + g_mailbox_stashCount[idx] < g_mailbox_slotReserve[idx])
+        {
+            slot_stash_push(idx, _slotptr);
+            return;
+        }
+    }
+
+    slab_free(_slotptr);
+}
+
+// PERF ADD Slots of a class the shared pool could hand out right now
+int slot_pool_room(int slotClass)
+{
+    return g_slabClassFree[slotClass] + g_slabFreePageCount * SLOTS_PER_PAGE(g_slotClassSize[slotClass]);
+}
+
+// PERF ADD allocate_slot would fail for lack of slots, not because of the quota
+int slot_pool_empty(int mboxIndex)
+{
+    return g_mailbox_stash[mboxIndex] == NULL && slot_pool_room(g_mailbox_slotClass[mboxIndex]) == 0;
+}
+
+// PERF ADD A mailbox with a quota may not hold more than that many slots at once
+int slot_quota_full(int mboxIndex)
+{
+    return g_mailbox_slotQuota[mboxIndex] > 0 &&
+        g_mailbox_slotsUsed[mboxIndex] >= g_mailbox_slotQuota[mboxIndex];
+}
+
+static void slot_stash_push(int mboxIndex, SlotPtr s)
+{
+    s->pNextSlot = g_mailbox_stash[mboxIndex];
+    s->pPrevSlot = NULL;
+    s->messageSize = 0;
+    s->slotState = SLOT_FREE;                   // not a message, slot_from_message rejects it
+    g_mailbox_stash[mboxIndex] = s;
+    g_mailbox_stashCount[mboxIndex]++;
+}
+
+// PERF ADD Set the guaranteed minimum and the quota of a mailbox. The stash is topped
+// up from the shared pool right away, so the minimum holds even if other mailboxes
+// later drain the pool. Returns -1 (nothing changed) if the pool cannot cover it.
+int slot_quota_set(int mboxIndex, int minSlots, int maxSlots)
+{
+    int have = g_mailbox_slotsUsed[mboxIndex] + g_mailbox_stashCount[mboxIndex];
+    int added = 0;
+
+    while (have + added < minSlots)
+    {
+        SlotPtr s = slab_alloc(g_mailbox_slotClass[mboxIndex]);
+        if (s == NULL)
+        {
+            while (added-- > 0)
+            {
+                SlotPtr t = g_mailbox_stash[mboxIndex];
+                g_mailbox_stash[mboxIndex] = t->pNextSlot;
+                g_mailbox_stashCount[mboxIndex]--;
+                slab_free(t);
+            }
+            return -1;
+        }
+        slot_stash_push(mboxIndex, s);
+        added++;
+    }
 
-    /* Maintain backward link on old head (keeps list consistent) */
-    if (freeSlotHead)
+    /* Lowered minimum: hand the surplus back */
+    while (g_mailbox_stashCount[mboxIndex] > 0 &&
+        g_mailbox_slotsUsed[mboxIndex] + g_mailbox_stashCount[mboxIndex] > minSlots)
     {
-        freeSlotHead->pPrevSlot = _slotptr;
+        SlotPtr t = g_mailbox_stash[mboxIndex];
+        g_mailbox_stash[mboxIndex] = t->pNextSlot;
+        g_mailbox_stashCount[mboxIndex]--;
+        slab_free(t);
     }
 
-    _slotptr->mbox_id = -1;
-    _slotptr->messageSize = 0;
+    g_mailbox_slotReserve[mboxIndex] = minSlots;
+    g_mailbox_slotQuota[mboxIndex] = maxSlots;
+    return 0;
+}
+
+// PERF ADD Drop the reservation of a freed mailbox and clear its usage counters
+void slot_quota_reset(int mboxIndex)
+{
+    while (g_mailbox_stash[mboxIndex] != NULL)
+    {
+        SlotPtr t = g_mailbox_stash[mboxIndex];
+        g_mailbox_stash[mboxIndex] = t->pNextSlot;
+        slab_free(t);
+    }
+
+    g_mailbox_stashCount[mboxIndex] = 0;
+    g_mailbox_slotReserve[mboxIndex] = 0;
+    g_mailbox_slotQuota[mboxIndex] = 0;
+    g_mailbox_slotsUsed[mboxIndex] = 0;
+    g_mailbox_slotsPeak[mboxIndex] = 0;
+    g_mailbox_quotaRejects[mboxIndex] = 0;
+}
+
+// PERF ADD Count a send that is returning: result 0 is a message sent, -2 a
+// non-blocking send turned away. Anything else is not counted.
+void stats_count_send(int mboxIndex, int result, int msgSize)
+{
+    if (result == 0)
+    {
+        g_mailbox_stats[mboxIndex].sends++;
+        g_mailbox_stats[mboxIndex].bytesSent += msgSize;
+        trace_event(MAILBOX_TRACE_SEND, k_getpid(), mailboxes[mboxIndex].mbox_id, msgSize);
+    }
+    else if (result == -2)
+    {
+        g_mailbox_stats[mboxIndex].wouldBlock++;
+    }
+}
+
+// PERF ADD Count a receive that is returning: a result >= 0 is the size of a
+// message received, -2 a non-blocking receive that found nothing.
+void stats_count_receive(int mboxIndex, int result)
+{
+    if (result >= 0)
+    {
+        g_mailbox_stats[mboxIndex].receives++;
+        g_mailbox_stats[mboxIndex].bytesReceived += result;
+        trace_event(MAILBOX_TRACE_RECEIVE, k_getpid(), mailboxes[mboxIndex].mbox_id, result);
+    }
+    else if (result == -2)
+    {
+        g_mailbox_stats[mboxIndex].wouldBlock++;
+    }
+}
+
+// PERF ADD Called after slotCount goes up.
+void stats_note_depth(int mboxIndex)
+{
+    if (mailboxes[mboxIndex].slotCount > g_mailbox_stats[mboxIndex].peakDepth)
+        g_mailbox_stats[mboxIndex].peakDepth = mailboxes[mboxIndex].slotCount;
+}
+
+// PERF ADD Called as me blocks. A call that blocks again after a wake that
+// came to nothing keeps its first start time.
+void latency_start(MsgProcEntry* me)
+{
+    if (!me->blockTimed)
+    {
+        me->blockStart = read_clock();
+        me->blockTimed = 1;
+    }
+}
+
+// PERF ADD The blocked call of me is over: add the time since latency_start
+// to the histogram of the mailbox it blocked on, unless that mailbox was
+// freed in the meantime. Bucket b > 0 holds times of b significant bits.
+static void latency_stop(MsgProcEntry* me)
+{
+    int mbIdx = mbox_index(me->blockedMbox);
+    if (mbIdx < 0)
+        return;
+
+    mailbox_latency_t* lat = &g_mailbox_latency[mbIdx];
+    unsigned int us = (unsigned int)(read_clock() - me->blockStart);
+    int b = 0;
+
+    for (unsigned int v = us; v != 0; v >>= 1)
+        b++;
+    if (b >= MAILBOX_LATENCY_BUCKETS)
+        b = MAILBOX_LATENCY_BUCKETS - 1;
+
+    lat->buckets[b]++;
+    lat->samples++;
+    if (us > lat->max)
+        lat->max = us;
+}
+
+// PERF ADD Top of the bucket that holds the pct'th percentile sample, capped
+// at the largest time seen.
+static unsigned int latency_percentile(const mailbox_latency_t* lat, int pct)
+{
+    int rank = (int)(((long long)lat->samples * pct + 99) / 100);
+    int seen = 0;
+
+    if (lat->samples == 0)
+        return 0;
+    for (int b = 0; b < MAILBOX_LATENCY_BUCKETS - 1; b++)
+    {
+        seen += lat->buckets[b];
+        if (seen >= rank)
+        {
+            unsigned int top = b == 0 ? 0 : (1u << b) - 1;
+            return top < lat->max ? top : lat->max;
+        }
+    }
+    return lat->max;
+}
+
+void latency_read(int mboxIndex, mailbox_latency_t* latency)
+{
+    *latency = g_mailbox_latency[mboxIndex];
+    latency->p50 = latency_percentile(latency, 50);
+    latency->p99 = latency_percentile(latency, 99);
+}
+
+// PERF ADD Fill the next record of the trace ring. Callers have interrupts
+// disabled, so the ring needs no lock; once it is full the oldest record is
+// overwritten. No allocation, no I/O, no call: a counter read and five stores.
+void trace_event(int event, int pid, int mboxId, int size)
+{
+    mailbox_trace_record_t* r = &g_traceRing[g_traceNext++ & (TRACE_RING_RECORDS - 1)];
+
+    r->timestamp = TRACE_STAMP();
+    r->event = event;
+    r->pid = pid;
+    r->mboxId = mboxId;
+    r->size = size;
+}
+
+// PERF ADD me is about to block; blockedMbox is -1 for sleeps.
+void trace_block(MsgProcEntry* me)
+{
+    trace_event(MAILBOX_TRACE_BLOCK, me->pid, me->blockedMbox, 0);
+}
+
+// PERF ADD pid is about to be unblocked. Its entry is still attached, so the
+// record names the mailbox it was blocked on.
+void trace_unblock(int pid)
+{
+    MsgProcEntry* me = mp_for_pid(pid);
+
+    trace_event(MAILBOX_TRACE_UNBLOCK, pid, me ? me->blockedMbox : -1, 0);
+}
+
+// PERF ADD Map a buffer handed out by the zero-copy calls back to its slot.
+// Anything that is not the message area of a slot in use gives NULL.
+SlotPtr slot_from_message(void* pMsg)
+{
+    unsigned char* base = mailSlotPages[0].bytes;
+    unsigned char* p = (unsigned char*)pMsg;
+
+    if (p < base + offsetof(MailSlot, message) || p >= base + sizeof(mailSlotPages))
+        return NULL;
 
-    freeSlotHead = _slotptr;
+    unsigned char* slotStart = p - offsetof(MailSlot, message);
+    int page = (int)((slotStart - base) / SLAB_PAGE_SIZE);
+    int slotClass = g_slabPages[page].slotClass;
+    if (slotClass < 0)
+        return NULL;
+
+    size_t offset = (size_t)(slotStart - mailSlotPages[page].bytes);
+    if (offset % SLOT_BYTES(g_slotClassSize[slotClass]) != 0 ||
+        offset / SLOT_BYTES(g_slotClassSize[slotClass]) >= (size_t)g_slabPages[page].carved)
+        return NULL;
+
+    SlotPtr s = (SlotPtr)slotStart;
+    if (s->slotState == SLOT_FREE)
+        return NULL;
+    return s;
 }
 
 // Initialize empty mailboxes
@@ -159,16 +612,290 @@ void init_mailboxes(void)
         mailboxes[i].slotCount = 0;
 
         g_mailbox_maxSlots[i] = 0;                  // TEST03 ADD: initialize maxSlots array to 0 for all mailboxes
+        g_mailbox_slotClass[i] = SLOT_CLASS_MAX;    // PERF ADD
+        g_mailbox_slotReserve[i] = 0;               // PERF ADD no reservation or quota by default
+        g_mailbox_slotQuota[i] = 0;
+        g_mailbox_slotsUsed[i] = 0;
+        g_mailbox_slotsPeak[i] = 0;
+        g_mailbox_quotaRejects[i] = 0;
+        memset(&g_mailbox_stats[i], 0, sizeof(g_mailbox_stats[i]));   // PERF ADD
+        memset(&g_mailbox_latency[i], 0, sizeof(g_mailbox_latency[i]));  // PERF ADD
+        g_mailbox_stash[i] = NULL;
+        g_mailbox_stashCount[i] = 0;
 
         g_slotTail[i] = NULL;                       // TEST05 ADD initialize slot, send, receive head and tails
         g_waitRecvHead[i] = NULL;
         g_waitRecvTail[i] = NULL;
         g_waitSendHead[i] = NULL;
         g_waitSendTail[i] = NULL;
+        g_mailbox_wakePolicy[i] = MBOX_WAKE_FIFO;   // PERF ADD
+        for (int l = 0; l < MESSAGE_LANES; l++)
+        {
+            g_slotLaneTail[i][l] = NULL;
+        }
+        for (int l = 0; l < WAKE_LEVELS; l++)
+        {
+            g_waitRecvLevelTail[i][l] = NULL;
+            g_waitSendLevelTail[i][l] = NULL;
+        }
+
+        g_freeMboxQueue[i] = i;                     // PERF ADD fresh table hands out ids 0, 1, 2, ...
+        g_mailboxRing[i].offset = -1;               // PERF ADD
+        g_mailboxRing[i].nextRing = -1;
+        g_mailboxMcast[i].parent = -1;              // PERF ADD
+        g_mailboxMcast[i].cursor = NULL;
+        g_mailboxMcast[i].subscribers = 0;
+        g_mailboxMcast[i].firstSub = -1;
+        g_mailboxMcast[i].lastSub = -1;
+        g_mailboxMcast[i].nextSub = -1;
+        g_mailboxMcast[i].prevSub = -1;
+        g_mailboxMcast[i].firstWaiting = -1;
+        g_mailboxMcast[i].lastWaiting = -1;
+        g_mailboxMcast[i].nextWaiting = -1;
+        g_mailboxMcast[i].waiting = 0;
     }
+    g_ringFirst = -1;
+    g_freeMboxHead = 0;
+    g_freeMboxCount = MAXMBOX;
+}
+
+// PERF ADD Take a free mailbox index in O(1) instead of scanning mailboxes[]
+int mbox_alloc_index(void)
+{
+    if (g_freeMboxCount == 0)
+        return -1;
+
+    int idx = g_freeMboxQueue[g_freeMboxHead];
+    g_freeMboxHead = (g_freeMboxHead + 1) % MAXMBOX;
+    g_freeMboxCount--;
+    return idx;
+}
+
+// PERF ADD Retire the current id of a freed mailbox and queue its index for reuse.
+// FIFO reuse keeps a freed index idle as long as possible, and the next create on it
+// hands out a new generation, so stale ids stay invalid.
+void mbox_release_index(int mboxIndex)
+{
+    MailBox* m = &mailboxes[mboxIndex];
+    int generation = m->mbox_id / MAXMBOX + 1;
+
+    if (generation >= MBOX_MAX_GENERATION)
+        generation = 0;
+
+    m->mbox_id = generation * MAXMBOX + mboxIndex;
+    g_freeMboxQueue[(g_freeMboxHead + g_freeMboxCount) % MAXMBOX] = mboxIndex;
+    g_freeMboxCount++;
+}
+
+// PERF ADD Validate a caller's mailbox id in O(1); the id must match the live generation
+int mbox_index(int mboxId)
+{
+    if (mboxId < 0)
+        return -1;
+
+    int idx = MBOX_INDEX(mboxId);
+    if (mailboxes[idx].status != MBSTATUS_INUSE || mailboxes[idx].mbox_id != mboxId)
+        return -1;
+
+    return idx;
+}
+
+// PERF ADD Find the first gap in the ring arena that holds slots entries.
+// Rings are kept in a list sorted by offset; this only runs at create time.
+int ring_reserve(int mboxIndex, int slots, int slotSize)
+{
+    int stride = RING_STRIDE(slotSize);
+    int bytes = slots * stride;
+    int gapStart = 0;
+    int prev = -1;
+    int r = g_ringFirst;
+
+    while (r >= 0 && g_mailboxRing[r].offset - gapStart < bytes)
+    {
+        gapStart = g_mailboxRing[r].offset + g_mailbox_maxSlots[r] * g_mailboxRing[r].stride;
+        prev = r;
+        r = g_mailboxRing[r].nextRing;
+    }
+    if (r < 0 && RING_ARENA_SIZE - gapStart < bytes)
+        return -1;
+
+    g_mailboxRing[mboxIndex].offset = gapStart;
+    g_mailboxRing[mboxIndex].stride = stride;
+    g_mailboxRing[mboxIndex].head = 0;
+    g_mailboxRing[mboxIndex].nextRing = r;
+    if (prev >= 0) g_mailboxRing[prev].nextRing = mboxIndex;
+    else g_ringFirst = mboxIndex;
+    return 0;
+}
+
+void ring_release(int mboxIndex)
+{
+    if (g_mailboxRing[mboxIndex].offset < 0)
+        return;
+
+    int* link = &g_ringFirst;
+    while (*link >= 0 && *link != mboxIndex)
+        link = &g_mailboxRing[*link].nextRing;
+    if (*link == mboxIndex)
+        *link = g_mailboxRing[mboxIndex].nextRing;
+
+    g_mailboxRing[mboxIndex].offset = -1;
+    g_mailboxRing[mboxIndex].nextRing = -1;
+}
+
+void ring_push(int mboxIndex, void* pMsg, int msgSize)
+{
+    MailboxRing* r = &g_mailboxRing[mboxIndex];
+    int entry = r->head + mailboxes[mboxIndex].slotCount;
+
+    if (entry >= g_mailbox_maxSlots[mboxIndex])
+        entry -= g_mailbox_maxSlots[mboxIndex];
+
+    unsigned char* p = g_ringArena + r->offset + entry * r->stride;
+    memcpy(p, &msgSize, sizeof(int));
+    if (msgSize > 0)
+        memcpy(p + sizeof(int), pMsg, (size_t)msgSize);
+}
+
+int ring_peek_size(int mboxIndex)
+{
+    MailboxRing* r = &g_mailboxRing[mboxIndex];
+    int msgSize;
+
+    memcpy(&msgSize, g_ringArena + r->offset + r->head * r->stride, sizeof(int));
+    return msgSize;
+}
+
+void ring_pop(int mboxIndex, void* pMsg)
+{
+    MailboxRing* r = &g_mailboxRing[mboxIndex];
+    unsigned char* p = g_ringArena + r->offset + r->head * r->stride;
+    int msgSize;
+
+    memcpy(&msgSize, p, sizeof(int));
+    if (msgSize > 0)
+        memcpy(pMsg, p + sizeof(int), (size_t)msgSize);
+
+    if (++r->head == g_mailbox_maxSlots[mboxIndex])
+        r->head = 0;
+}
+
+// PERF ADD Append a subscription to a multicast mailbox. It receives what is sent from
+// now on, so its cursor starts at the spare slot.
+void mcast_subscribe(int subIndex, int mboxIndex)
+{
+    MailboxMulticast* mc = &g_mailboxMcast[mboxIndex];
+    MailboxMulticast* sub = &g_mailboxMcast[subIndex];
+
+    sub->parent = mboxIndex;
+    sub->cursor = g_slotTail[mboxIndex];
+    sub->nextSub = -1;
+    sub->prevSub = mc->lastSub;
+    if (mc->lastSub >= 0) g_mailboxMcast[mc->lastSub].nextSub = subIndex;
+    else mc->firstSub = subIndex;
+    mc->lastSub = subIndex;
+    mc->subscribers++;
+}
+
+// PERF ADD Take a subscription off its multicast mailbox. The messages it had not
+// received yet no longer wait for it; returns how many slots that freed.
+int mcast_unsubscribe(int subIndex)
+{
+    MailboxMulticast* sub = &g_mailboxMcast[subIndex];
+    int mboxIndex = sub->parent;
+
+    if (mboxIndex < 0)
+        return 0;
+
+    MailboxMulticast* mc = &g_mailboxMcast[mboxIndex];
+    for (SlotPtr s = sub->cursor; s != g_slotTail[mboxIndex]; s = s->pNextSlot)
+        s->refCount--;
+
+    if (sub->prevSub >= 0) g_mailboxMcast[sub->prevSub].nextSub = sub->nextSub;
+    else mc->firstSub = sub->nextSub;
+    if (sub->nextSub >= 0) g_mailboxMcast[sub->nextSub].prevSub = sub->prevSub;
+    else mc->lastSub = sub->prevSub;
+    mc->subscribers--;
+
+    if (sub->waiting)
+    {
+        int prev = -1;
+        for (int w = mc->firstWaiting; w != subIndex; w = g_mailboxMcast[w].nextWaiting)
+            prev = w;
+        if (prev >= 0) g_mailboxMcast[prev].nextWaiting = sub->nextWaiting;
+        else mc->firstWaiting = sub->nextWaiting;
+        if (mc->lastWaiting == subIndex) mc->lastWaiting = prev;
+        sub->waiting = 0;
+        sub->nextWaiting = -1;
+    }
+
+    sub->parent = -1;
+    sub->cursor = NULL;
+    sub->nextSub = sub->prevSub = -1;
+    return mcast_reclaim(mboxIndex);
+}
+
+// PERF ADD The subscription has received the message at its cursor
+void mcast_advance(int subIndex)
+{
+    MailboxMulticast* sub = &g_mailboxMcast[subIndex];
+    SlotPtr s = sub->cursor;
+
+    sub->cursor = s->pNextSlot;
+    s->refCount--;
+}
+
+// PERF ADD Put a subscription on the waiting list of its multicast mailbox. Entries
+// whose receiver has gone again (timed out, signaled) are dropped by the next send.
+void mcast_mark_waiting(int subIndex)
+{
+    MailboxMulticast* sub = &g_mailboxMcast[subIndex];
+
+    if (sub->waiting || sub->parent < 0)
+        return;
+
+    MailboxMulticast* mc = &g_mailboxMcast[sub->parent];
+    sub->waiting = 1;
+    sub->nextWaiting = -1;
+    if (mc->lastWaiting >= 0) g_mailboxMcast[mc->lastWaiting].nextWaiting = subIndex;
+    else mc->firstWaiting = subIndex;
+    mc->lastWaiting = subIndex;
+}
+
+// PERF ADD Free the head slots every subscription has received. The spare slot at
+// the tail always stays.
+int mcast_reclaim(int mboxIndex)
+{
+    MailBox* m = &mailboxes[mboxIndex];
+    int freed = 0;
+
+    while (m->pSlotListHead != g_slotTail[mboxIndex] && m->pSlotListHead->refCount == 0)
+    {
+        SlotPtr s = m->pSlotListHead;
+
+        m->pSlotListHead = s->pNextSlot;
+        m->pSlotListHead->pPrevSlot = NULL;
+        free_slot(s);
+        m->slotCount--;
+        freed++;
+    }
+    return freed;
+}
+
+// PERF ADD n is leaving its queue: if it is the last node of its priority,
+// the one before it takes over when it has the same priority.
+static void waitq_level_unlink(WaitingProcessPtr n) {
+    WaitingProcessPtr* levelTail;
+
+    if (!n->pLevelTails) return;
+    levelTail = &n->pLevelTails[n->priority - LOWEST_PRIORITY];
+    if (*levelTail == n)
+        *levelTail = (n->pPrevProcess && n->pPrevProcess->priority == n->priority) ? n->pPrevProcess : NULL;
+    n->pLevelTails = NULL;
 }
 
 void waitq_push(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr n) {
+    n->pLevelTails = NULL;                          // PERF ADD
     n->pNextProcess = NULL;
     n->pPrevProcess = *tail;
     if (*tail) (*tail)->pNextProcess = n;
@@ -176,9 +903,20 @@ void waitq_push(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcess
     *tail = n;
 }
 
+// PERF ADD unlink a node from anywhere in a wait queue
+void waitq_remove(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr n) {
+    waitq_level_unlink(n);                          // PERF ADD
+    if (n->pPrevProcess) n->pPrevProcess->pNextProcess = n->pNextProcess;
+    else *head = n->pNextProcess;
+    if (n->pNextProcess) n->pNextProcess->pPrevProcess = n->pPrevProcess;
+    else *tail = n->pPrevProcess;
+    n->pNextProcess = n->pPrevProcess = NULL;
+}
+
 WaitingProcessPtr waitq_pop(WaitingProcessPtr* head, WaitingProcessPtr* tail) {
     WaitingProcessPtr n = *head;
     if (!n) return NULL;
+    waitq_level_unlink(n);                          // PERF ADD
     *head = n->pNextProcess;
     if (*head) (*head)->pPrevProcess = NULL;
     else *tail = NULL;
@@ -186,22 +924,80 @@ WaitingProcessPtr waitq_pop(WaitingProcessPtr* head, WaitingProcessPtr* tail) {
     return n;
 }
 
-void slot_enqueue(int mboxId, SlotPtr s) {
-    MailBox* m = &mailboxes[mboxId];
-    s->pNextSlot = NULL;
-    s->pPrevSlot = g_slotTail[mboxId];
-    if (g_slotTail[mboxId]) g_slotTail[mboxId]->pNextSlot = s;
+// PERF ADD Insert n behind the last waiter of equal or higher priority: that is
+// the last node of its own level, or of the nearest higher level in use. O(1)
+// for the fixed number of levels.
+void waitq_push_priority(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr* levelTails, WaitingProcessPtr n) {
+    WaitingProcessPtr after = NULL;
+
+    for (int l = n->priority - LOWEST_PRIORITY; l < WAKE_LEVELS && !after; l++)
+        after = levelTails[l];
+
+    n->pPrevProcess = after;
+    n->pNextProcess = after ? after->pNextProcess : *head;
+    if (n->pNextProcess) n->pNextProcess->pPrevProcess = n;
+    else *tail = n;
+    if (after) after->pNextProcess = n;
+    else *head = n;
+
+    levelTails[n->priority - LOWEST_PRIORITY] = n;
+    n->pLevelTails = levelTails;
+}
+
+void recvq_push(int mboxIndex, WaitingProcessPtr n) {
+    if (mailboxes[mboxIndex].type == MB_SUBSCRIPTION)     // PERF ADD
+        mcast_mark_waiting(mboxIndex);
+    if (g_mailbox_wakePolicy[mboxIndex] != MBOX_WAKE_PRIORITY) {
+        waitq_push(&g_waitRecvHead[mboxIndex], &g_waitRecvTail[mboxIndex], n);
+        return;
+    }
+    n->priority = wake_priority(n->pid);
+    waitq_push_priority(&g_waitRecvHead[mboxIndex], &g_waitRecvTail[mboxIndex], g_waitRecvLevelTail[mboxIndex], n);
+}
+
+void sendq_push(int mboxIndex, WaitingProcessPtr n) {
+    if (g_mailbox_wakePolicy[mboxIndex] != MBOX_WAKE_PRIORITY) {
+        waitq_push(&g_waitSendHead[mboxIndex], &g_waitSendTail[mboxIndex], n);
+        return;
+    }
+    n->priority = wake_priority(n->pid);
+    waitq_push_priority(&g_waitSendHead[mboxIndex], &g_waitSendTail[mboxIndex], g_waitSendLevelTail[mboxIndex], n);
+}
+
+int wake_priority(int pid) {
+    if (pid >= 0 && g_wakePriorityPid[MP_BUCKET(pid)] == pid)
+        return g_wakePriority[MP_BUCKET(pid)];
+    return LOWEST_PRIORITY;
+}
+
+void slot_enqueue(int mboxIndex, SlotPtr s, int lane) {
+    MailBox* m = &mailboxes[mboxIndex];
+    SlotPtr after = NULL;
+
+    /* PERF ALTER behind the last slot of this lane or the nearest higher one in use */
+    for (int l = lane; l < MESSAGE_LANES && !after; l++)
+        after = g_slotLaneTail[mboxIndex][l];
+
+    s->pPrevSlot = after;
+    s->pNextSlot = after ? after->pNextSlot : m->pSlotListHead;
+    if (s->pNextSlot) s->pNextSlot->pPrevSlot = s;
+    else g_slotTail[mboxIndex] = s;
+    if (after) after->pNextSlot = s;
     else m->pSlotListHead = s;
-    g_slotTail[mboxId] = s;
+
+    s->lane = lane;
+    g_slotLaneTail[mboxIndex][lane] = s;
 }
 
-SlotPtr slot_dequeue(int mboxId) {
-    MailBox* m = &mailboxes[mboxId];
+SlotPtr slot_dequeue(int mboxIndex) {
+    MailBox* m = &mailboxes[mboxIndex];
     SlotPtr s = m->pSlotListHead;
     if (!s) return NULL;
+    if (g_slotLaneTail[mboxIndex][s->lane] == s)   // PERF ADD the head is the first of its lane
+        g_slotLaneTail[mboxIndex][s->lane] = NULL;
     m->pSlotListHead = s->pNextSlot;
     if (m->pSlotListHead) m->pSlotListHead->pPrevSlot = NULL;
-    else g_slotTail[mboxId] = NULL;
+    else g_slotTail[mboxIndex] = NULL;
     s->pNextSlot = s->pPrevSlot = NULL;
     return s;
 }
@@ -224,9 +1020,49 @@ int device_id_from_param(char deviceId[32])
 
 /* TEST05 ADD: proc table helpers */
 /* TEST09 FIX proc table helpers */
+/* PERF ADD entries are attached for the length of one blocking call and found
+   through the pid hash, or directly from a wait queue node, in O(1). */
+MsgProcEntry* mp_attach(int pid)
+{
+    int idx = mp_lookup(pid);
+    if (idx >= 0)
+        return &g_msgProc[idx];
+
+    if (pid < 0 || g_freeProcCount == 0)
+        return NULL;
+
+    idx = g_freeProcStack[--g_freeProcCount];
+    mp_reset(idx, pid);
+    g_msgProc[idx].hashNext = g_pidBucket[MP_BUCKET(pid)];
+    g_pidBucket[MP_BUCKET(pid)] = idx;
+    return &g_msgProc[idx];
+}
+
+void mp_detach(MsgProcEntry* me)
+{
+    if (!me || me->pid < 0) return;
+
+    int idx = (int)(me - g_msgProc);
+    int* link = &g_pidBucket[MP_BUCKET(me->pid)];
+
+    while (*link >= 0 && *link != idx)
+        link = &g_msgProc[*link].hashNext;
+    if (*link == idx)
+        *link = me->hashNext;
+
+    if (me->poolWoken)                              // PERF ADD woken pool waiter has had its retry
+        g_poolWoken[me->poolClass]--;
+    timer_cancel(me);                               // PERF ADD
+    if (me->blockTimed)                             // PERF ADD finish_blocked_call and the retry paths all end here
+        latency_stop(me);
+
+    mp_reset(idx, -1);
+    g_freeProcStack[g_freeProcCount++] = idx;
+}
+
 MsgProcEntry* mp_for_pid(int pid)
 {
-    int idx = mpIndex(pid);
+    int idx = mp_lookup(pid);
     if (idx < 0) return NULL;
     return &g_msgProc[idx];
 }
@@ -236,15 +1072,62 @@ MsgProcEntry* mp_self(void)
     return mp_for_pid(k_getpid());
 }
 
-WaitingProcessPtr wp_for_pid(int pid)
+MsgProcEntry* mp_for_node(WaitingProcessPtr node)
 {
-    int idx = mpIndex(pid);
-    if (idx < 0) return NULL;
+    if (!node) return NULL;
+    if (node >= &g_anyNode[0][0] && node < &g_anyNode[0][0] + MAXPROC * MAX_RECEIVE_ANY)     // PERF ADD queued by mailbox_receive_any
+        return &g_msgProc[(node - &g_anyNode[0][0]) / MAX_RECEIVE_ANY];
+    return &g_msgProc[node - g_waitNode];
+}
 
-    g_waitNode[idx].pid = pid;
-    g_waitNode[idx].pNextProcess = NULL;
-    g_waitNode[idx].pPrevProcess = NULL;
-    return &g_waitNode[idx];
+// PERF ADD A mailbox_receive_any caller is being woken through node (already popped).
+// Record which mailbox it was and unlink its other nodes, so no second message is
+// handed to the same buffer. A plain receiver is left alone.
+void any_wait_claim(WaitingProcessPtr node)
+{
+    MsgProcEntry* me = mp_for_node(node);
+    if (!me || me->anyCount == 0)
+        return;
+
+    int idx = (int)(me - g_msgProc);
+    int which = (int)(node - g_anyNode[idx]);
+
+    me->anyMbox[which] = -1;
+    any_wait_cancel(me);
+    me->anyWhich = which;
+}
+
+// PERF ADD Unlink every node of a mailbox_receive_any caller that is still queued
+void any_wait_cancel(MsgProcEntry* me)
+{
+    int idx = (int)(me - g_msgProc);
+
+    for (int i = 0; i < me->anyCount; i++)
+    {
+        int mbIdx = me->anyMbox[i];
+        if (mbIdx >= 0)
+        {
+            waitq_remove(&g_waitRecvHead[mbIdx], &g_waitRecvTail[mbIdx], &g_anyNode[idx][i]);
+            me->anyMbox[i] = -1;
+        }
+    }
+}
+
+WaitingProcessPtr wp_for_entry(MsgProcEntry* me)
+{
+    if (!me) return NULL;
+
+    WaitingProcessPtr node = &g_waitNode[me - g_msgProc];
+    node->pid = me->pid;
+    node->pNextProcess = NULL;
+    node->pPrevProcess = NULL;
+    node->pLevelTails = NULL;                       // PERF ADD
+    return node;
+}
+
+WaitingProcessPtr wp_for_pid(int pid)
+{
+    return wp_for_entry(mp_for_pid(pid));
 }
 
 void prepare_blocked_sender(MsgProcEntry* me, int mboxId, void* pMsg, int msg_size)
@@ -252,8 +1135,10 @@ void prepare_blocked_sender(MsgProcEntry* me, int mboxId, void* pMsg, int msg_si
     me->sendBuf = pMsg;
     me->sendSize = msg_size;
     me->sendResult = -9999;
+    me->sendLane = 0;                               // PERF ADD mailbox_send_prio sets its own afterwards
     me->blockedMbox = mboxId;
     me->blockedType = BLOCKED_SEND;
+    latency_start(me);                              // PERF ADD
 }
 
 void prepare_blocked_receiver(MsgProcEntry* me, int mboxId, void* pMsg, int msg_size)
@@ -263,12 +1148,232 @@ void prepare_blocked_receiver(MsgProcEntry* me, int mboxId, void* pMsg, int msg_
     me->recvResult = -9999;
     me->blockedMbox = mboxId;
     me->blockedType = BLOCKED_RECEIVE;
+    latency_start(me);                              // PERF ADD
 }
 
 int finish_blocked_call(MsgProcEntry* me, int result)
 {
-    me->blockedMbox = -1;
-    me->blockedType = 0;
+    mp_detach(me);                                  // PERF ADD entry is only needed while blocked
     enableInterrupts();
     return result;
-}
\ No newline at end of file
+}
+
+static void timer_node_file(int n);         // PERF ADD
+static void timer_node_unlink(int n);       // PERF ADD
+static int timer_expire(MsgProcEntry* me);  // PERF ADD
+static int timer_fire(int n);               // PERF ADD
+
+// PERF ADD Put node n in the inner bucket of its deadline if that is less than a
+// turn away, otherwise in the outer bucket of the turn it falls in. O(1).
+// Deadlines are after the current tick, except while timer_tick moves an outer
+// bucket down, when a deadline of the current tick is still to be looked at.
+static void timer_node_file(int n)
+{
+    unsigned now = (unsigned)g_clockTicks;
+    unsigned deadline = (unsigned)g_timerNode[n].deadline;
+    int bucket;
+
+    if ((int)(deadline - now) < 0)
+    {
+        bucket = (int)((now + 1) % TIMER_WHEEL_SLOTS);         // overdue, expire on the next tick
+    }
+    else if (deadline - now < TIMER_WHEEL_SLOTS)
+    {
+        bucket = (int)(deadline % TIMER_WHEEL_SLOTS);
+    }
+    else
+    {
+        unsigned turns = (deadline >> TIMER_WHEEL_BITS) - (now >> TIMER_WHEEL_BITS);
+        if (turns >= TIMER_OUTER_SLOTS)
+            turns = TIMER_OUTER_SLOTS - 1;                      // beyond the outer wheel, refiled later
+        bucket = TIMER_WHEEL_SLOTS + (int)(((now >> TIMER_WHEEL_BITS) + turns) % TIMER_OUTER_SLOTS);
+    }
+
+    g_timerNode[n].bucket = bucket;
+    g_timerNode[n].prev = -1;
+    g_timerNode[n].next = g_timerWheel[bucket];
+    if (g_timerWheel[bucket] >= 0)
+        g_timerNode[g_timerWheel[bucket]].prev = n;
+    g_timerWheel[bucket] = n;
+}
+
+// PERF ADD Take node n out of its bucket. O(1).
+static void timer_node_unlink(int n)
+{
+    TimerNode* t = &g_timerNode[n];
+
+    if (t->prev >= 0) g_timerNode[t->prev].next = t->next;
+    else g_timerWheel[t->bucket] = t->next;
+    if (t->next >= 0) g_timerNode[t->next].prev = t->prev;
+
+    t->bucket = -1;
+    t->next = t->prev = -1;
+}
+
+// PERF ADD Arm the timeout of me for tick deadline. O(1).
+void timer_arm(MsgProcEntry* me, int deadline)
+{
+    int n = (int)(me - g_msgProc);
+
+    timer_cancel(me);
+    g_timerNode[n].deadline = deadline;
+    timer_node_file(n);
+    g_timersArmed++;
+}
+
+// PERF ADD Disarm the timeout of me, if any. O(1).
+void timer_cancel(MsgProcEntry* me)
+{
+    int n = (int)(me - g_msgProc);
+
+    if (g_timerNode[n].bucket < 0)
+        return;
+
+    timer_node_unlink(n);
+    g_timersArmed--;
+}
+
+// PERF ADD Start a periodic timer, first expiry one period from now. O(1).
+int periodic_timer_alloc(int periodTicks)
+{
+    int t, n;
+
+    if (g_freeTimerCount == 0)
+        return -1;
+
+    t = g_freeTimerStack[--g_freeTimerCount];
+    n = TIMER_NODE_PERIODIC(t);
+    g_periodicTimer[t].inUse = 1;
+    g_periodicTimer[t].period = periodTicks;
+    g_periodicTimer[t].pending = 0;
+    g_periodicTimer[t].waiter = -1;
+
+    g_timerNode[n].deadline = (int)((unsigned)g_clockTicks + (unsigned)periodTicks);
+    timer_node_file(n);
+    g_timersArmed++;
+    return t;
+}
+
+// PERF ADD Stop a periodic timer and return its index to the free stack. O(1).
+int periodic_timer_release(int timerIndex)
+{
+    int n = TIMER_NODE_PERIODIC(timerIndex);
+    int waiter = g_periodicTimer[timerIndex].waiter;
+
+    if (g_timerNode[n].bucket >= 0)
+    {
+        timer_node_unlink(n);
+        g_timersArmed--;
+    }
+    g_periodicTimer[timerIndex].inUse = 0;
+    g_periodicTimer[timerIndex].waiter = -1;
+    g_freeTimerStack[g_freeTimerCount++] = timerIndex;
+    return waiter;
+}
+
+// PERF ADD The blocked call of me ran out of time. If it is still on a wait queue,
+// unlink it and return its pid to be woken; if someone already woke it, its own
+// result stands and -1 is returned.
+static int timer_expire(MsgProcEntry* me)
+{
+    int idx = (int)(me - g_msgProc);
+    WaitingProcessPtr node = &g_waitNode[idx];
+    WaitingProcessPtr* head;
+    WaitingProcessPtr* tail;
+
+    timer_cancel(me);
+
+    if (me->blockedType == BLOCKED_SLEEP)
+    {
+        me->timedOut = 1;                                   // k_sleep is on no queue
+        return me->pid;
+    }
+
+    if (me->blockedType == BLOCKED_RECEIVE)
+    {
+        head = &g_waitRecvHead[MBOX_INDEX(me->blockedMbox)];
+        tail = &g_waitRecvTail[MBOX_INDEX(me->blockedMbox)];
+    }
+    else if (me->poolClass >= 0)
+    {
+        head = &g_poolWaitHead;
+        tail = &g_poolWaitTail;
+    }
+    else
+    {
+        head = &g_waitSendHead[MBOX_INDEX(me->blockedMbox)];
+        tail = &g_waitSendTail[MBOX_INDEX(me->blockedMbox)];
+    }
+
+    if (node->pPrevProcess == NULL && *head != node)
+        return -1;
+
+    waitq_remove(head, tail, node);
+    me->timedOut = 1;
+    return me->pid;
+}
+
+// PERF ADD Node n is due: expire a timeout or sleep, or count one period of a
+// periodic timer and arm the next. Returns the pid to wake, or -1.
+static int timer_fire(int n)
+{
+    if (n < MAXPROC)
+        return timer_expire(&g_msgProc[n]);
+
+    PeriodicTimer* pt = &g_periodicTimer[n - MAXPROC];
+    int waiter = pt->waiter;
+
+    timer_node_unlink(n);
+    pt->pending++;
+    pt->waiter = -1;
+    g_timerNode[n].deadline = (int)((unsigned)g_timerNode[n].deadline + (unsigned)pt->period);   // no drift
+    timer_node_file(n);
+    return waiter;
+}
+
+// PERF ADD One clock interrupt. When the inner wheel comes round, move the next
+// outer bucket down into it; then fire what is due in the inner bucket of the
+// new tick. Every node is moved down at most once, or once per turn of the
+// outer wheel if its deadline lies beyond it.
+void timer_tick(void)
+{
+    int wakePids[MAXPROC];
+    int wakeCount = 0;
+    unsigned now = (unsigned)g_clockTicks + 1;
+    int i;
+
+    g_clockTicks = (int)now;
+
+    if (now % TIMER_WHEEL_SLOTS == 0)
+    {
+        int outer = TIMER_WHEEL_SLOTS + (int)((now >> TIMER_WHEEL_BITS) % TIMER_OUTER_SLOTS);
+        i = g_timerWheel[outer];
+        g_timerWheel[outer] = -1;
+        while (i >= 0)
+        {
+            int next = g_timerNode[i].next;
+            timer_node_file(i);
+            i = next;
+        }
+    }
+
+    i = g_timerWheel[now % TIMER_WHEEL_SLOTS];
+    while (i >= 0)
+    {
+        int next = g_timerNode[i].next;
+        if ((int)((unsigned)g_timerNode[i].deadline - now) <= 0)
+        {
+            int pid = timer_fire(i);
+            if (pid >= 0)
+                wakePids[wakeCount++] = pid;
+        }
+        i = next;
+    }
+
+    /* unblock may switch to a woken process, so leave the wheel alone from here */
+    for (i = 0; i < wakeCount; i++)
+    {
+        trace_unblock(wakePids[i]);                         // PERF ADD
+        unblock(wakePids[i]);
+    }
+}
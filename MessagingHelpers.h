@@ -2,6 +2,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <limits.h>
 #include <THREADSLib.h>
 #include <Scheduler.h>
 #include <Messaging.h>
@@ -9,6 +10,140 @@
 
 /* ------------------------- Internal Types -------------------------------- */
 
+/* Mailbox ids carry a generation tag: id = generation * MAXMBOX + table index.
+ * The first generation is the bare index, so fresh ids match the table slot. */
+#define MBOX_INDEX(id)          ((id) % MAXMBOX)
+#define MBOX_MAX_GENERATION     (INT_MAX / MAXMBOX)
+
+/* Hash bucket of a pid in the messaging process table */
+#define MP_BUCKET(pid)          ((pid) % MAXPROC)
+
+/* PERF ADD Mail slots come in size classes carved from fixed-size slab pages.
+ * A page holds slots of one class only and returns to the shared page pool
+ * once its last slot is freed, so any class can use the whole arena. The
+ * arena is sized to hold MAXSLOTS slots of the largest class. */
+#define SLOT_CLASS_COUNT        3
+#define SLOT_CLASS_MAX          (SLOT_CLASS_COUNT - 1)
+#define SLAB_PAGE_SIZE          4096
+#define SLOT_BYTES(msgSize)     (sizeof(MailSlot) + (((msgSize) + 7) & ~7))
+#define SLOTS_PER_PAGE(msgSize) ((int)(SLAB_PAGE_SIZE / SLOT_BYTES(msgSize)))
+#define SLAB_PAGES              ((MAXSLOTS + SLOTS_PER_PAGE(MAX_MESSAGE) - 1) / SLOTS_PER_PAGE(MAX_MESSAGE))
+
+/* PERF ADD Timeouts, sleeps and periodic timers are kept on a two-level
+ * timer wheel indexed by clock interrupt. The inner wheel has one bucket per
+ * tick for the next TIMER_WHEEL_SLOTS ticks; the outer wheel has one bucket
+ * per turn of the inner wheel. Each time the inner wheel comes round, the
+ * next outer bucket is moved down into it. A tick looks at one inner bucket,
+ * and a timer moves down at most once, so each tick costs amortized O(1).
+ * Deadlines beyond the outer wheel wait in its last bucket and are refiled
+ * when that bucket comes round. */
+#define CLOCK_TICK_MS           20      /* THREADS clock interrupt period */
+#define CLOCK_DEVICE_INTERRUPTS 5       /* clock interrupts per tick sent to wait_device("clock") */
+#define TIMER_WHEEL_BITS        8
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_BITS)     /* inner buckets, one tick each */
+#define TIMER_OUTER_SLOTS       64                          /* outer buckets, one inner turn each */
+#define TIMER_WHEEL_BUCKETS     (TIMER_WHEEL_SLOTS + TIMER_OUTER_SLOTS)
+#define MS_TO_TICKS(ms)         (((ms) + CLOCK_TICK_MS - 1) / CLOCK_TICK_MS)
+
+/* PERF ADD Timer nodes 0..MAXPROC-1 belong to the g_msgProc entries of the
+ * same index (timeouts and k_sleep); the rest are the periodic timers. */
+#define TIMER_NODES             (MAXPROC + MAX_PERIODIC_TIMERS)
+#define TIMER_NODE_PERIODIC(t)  (MAXPROC + (t))
+
+/* PERF ADD MBOX_WAKE_PRIORITY wait queues stay sorted by wake priority. Each
+ * queue keeps the last node of every priority level, so a new waiter is put
+ * behind its equals in O(1) without walking the queue. Processes that never
+ * call mailbox_set_wake_priority wait at LOWEST_PRIORITY. */
+#define WAKE_LEVELS             (HIGHEST_PRIORITY - LOWEST_PRIORITY + 1)
+
+/* PERF ADD Queued slots are kept in one list, highest lane first and FIFO
+ * within a lane. The last slot of every lane is remembered, so a send goes
+ * behind its lane in O(1) and a receive still takes the list head. */
+
+/* PERF ADD Internal send result: the shared slot pool is empty. Blocking
+ * senders wait on the pool queue, non-blocking callers see -2. */
+#define SLOT_POOL_EMPTY         (-3)
+
+/* PERF ADD event trace ring, a power of two so the index is a mask */
+#define TRACE_RING_RECORDS      4096
+
+/* PERF ADD trace clock. The time-stamp counter is one instruction, where
+ * read_clock() is a call into THREADS that costs more than the rest of a
+ * trace record; the dump header pairs the two so readers can convert. */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TRACE_STAMP()           __rdtsc()
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define TRACE_STAMP()           __rdtsc()
+#else
+#define TRACE_STAMP()           ((uint64_t)read_clock())
+#endif
+
+typedef union {
+    unsigned char bytes[SLAB_PAGE_SIZE];
+    SlotPtr align;                  // keep slots pointer-aligned
+} SlabPageMem;
+
+typedef struct {
+    int slotClass;                  // -1 while the page sits in the free page pool
+    int inUse;                      // slots handed out from this page
+    int carved;                     // slots carved so far, the rest is untouched
+    SlotPtr freeList;               // slots freed back to this page
+    int next;                       // next page in the class partial list or the free pool
+    int prev;                       // previous page in the class partial list
+} SlabPage;
+
+/* PERF ADD Ring mailboxes keep their messages in one contiguous block of the
+ * ring arena instead of linked slots. Entry i starts at offset + i * stride
+ * with the message size, followed by the message bytes. */
+#define RING_ARENA_SIZE         (256 * 1024)
+#define RING_STRIDE(slotSize)   ((int)((sizeof(int) + (slotSize) + 3) & ~3))
+
+typedef struct {
+    int offset;                     // start of the ring in g_ringArena, -1 if not a ring mailbox
+    int stride;                     // bytes per entry
+    int head;                       // entry that is received next
+    int nextRing;                   // next ring mailbox by offset, -1 at end
+} MailboxRing;
+
+/* PERF ADD A multicast mailbox stores each message once, in a slot shared by
+ * all of its subscriptions. Its slot list runs from the oldest message some
+ * subscription has not received yet to a spare slot (g_slotTail) that the
+ * next send writes into. Every subscription is a mailbox of its own with a
+ * cursor at the next slot it receives, the spare slot once it has caught
+ * up. A message slot counts the subscriptions still to receive it and is
+ * freed when the count reaches 0; that is always the head, since every
+ * subscription receives in order. Subscriptions that get a blocked receiver
+ * are listed on their multicast mailbox, so a send only looks at those. */
+typedef struct {
+    int parent;                     // subscription: table index of its multicast mailbox, -1 if none
+    SlotPtr cursor;                 // subscription: next slot to receive
+    int subscribers;                // multicast mailbox: number of subscriptions
+    int firstSub;                   // multicast mailbox: first and last subscription, -1 if none
+    int lastSub;
+    int nextSub;                    // subscription: neighbours in the list of its multicast mailbox
+    int prevSub;
+    int firstWaiting;               // multicast mailbox: subscriptions with a blocked receiver, -1 if none
+    int lastWaiting;
+    int nextWaiting;                // subscription: next on that list, -1 at end
+    int waiting;                    // subscription: 1 while on that list
+} MailboxMulticast;
+
+typedef struct {
+    int deadline;                   // clock tick the timer expires at
+    int bucket;                     // wheel bucket, -1 if not armed
+    int next;                       // next node in the same bucket, -1 at end
+    int prev;                       // previous node in the same bucket, -1 at head
+} TimerNode;
+
+typedef struct {
+    int inUse;
+    int period;                     // ticks between expiries
+    int pending;                    // expiries not yet collected by periodic_timer_wait
+    int waiter;                     // pid blocked in periodic_timer_wait, -1 if none
+} PeriodicTimer;
+
 /* TEST05 ADD Messaging internal state */
 typedef struct {
     int pid;
@@ -19,45 +154,149 @@ typedef struct {
     void* sendBuf;
     int sendSize;
     int sendResult;
+    int sendLane;         // PERF ADD message priority lane of the pending send
 
     int blockedMbox;      // TEST09 ADD
     int blockedType;      // TEST09 ADD
+    int hashNext;         // PERF ADD next entry in the same pid bucket, -1 at end
+    int inPlace;          // PERF ADD blocked in mailbox_send_reserve / mailbox_receive_acquire
+    SlotPtr inPlaceSlot;  // PERF ADD slot handed to a woken mailbox_send_reserve caller
+    int poolClass;        // PERF ADD slot class waited for on the slot pool queue
+    int poolWoken;        // PERF ADD woken from the slot pool queue, retry still to come
+    int anyCount;         // PERF ADD mailboxes a mailbox_receive_any caller waits on, 0 otherwise
+    int anyWhich;         // PERF ADD position in the id list of the mailbox that woke it
+    int anyMbox[MAX_RECEIVE_ANY];   // PERF ADD table index each any-node is queued on, -1 once unlinked
+    int timedOut;         // PERF ADD woken because the timeout ran out
+    int blockTimed;       // PERF ADD blockStart is set, the block is added to a histogram on detach
+    DWORD blockStart;     // PERF ADD read_clock() when the call blocked
 } MsgProcEntry;
 
 /* ------------------------- Extern Globals -------------------------------- */
 
 /* These are defined in Messaging.c */
 extern MailBox mailboxes[MAXMBOX];
-extern MailSlot mailSlots[MAXSLOTS];
+extern SlabPageMem mailSlotPages[SLAB_PAGES];     // PERF ADD slab arena that holds the mail slots
 
 /* These are defined in MessagingHelpers.c */
-extern SlotPtr freeSlotHead;                 // Slot free list management   TEST02 ADD
 extern int g_mailbox_maxSlots[MAXMBOX];      // TEST03 ADD
+extern int g_mailbox_slotClass[MAXMBOX];     // PERF ADD slot size class picked by mailbox_create
+extern int g_mailbox_slotReserve[MAXMBOX];   // PERF ADD slots guaranteed to the mailbox, 0 if none
+extern int g_mailbox_slotQuota[MAXMBOX];     // PERF ADD most slots the mailbox may hold, 0 if no quota
+extern int g_mailbox_slotsUsed[MAXMBOX];     // PERF ADD slots charged to the mailbox right now
+extern int g_mailbox_slotsPeak[MAXMBOX];     // PERF ADD high-water mark of g_mailbox_slotsUsed
+extern int g_mailbox_quotaRejects[MAXMBOX];  // PERF ADD sends turned away by the quota
+extern mailbox_stats_t g_mailbox_stats[MAXMBOX];    // PERF ADD traffic counters, depth is filled in on read
+extern mailbox_latency_t g_mailbox_latency[MAXMBOX];    // PERF ADD blocking-time histograms, percentiles are filled in on read
+extern mailbox_trace_record_t g_traceRing[TRACE_RING_RECORDS];  // PERF ADD event trace, oldest records overwritten
+extern uint32_t g_traceNext;                 // PERF ADD records ever written to g_traceRing
+extern mailbox_trace_record_t g_traceCopy[TRACE_RING_RECORDS];  // PERF ADD the ring, oldest first, as a dump writes it
+extern int g_traceDumping;                   // PERF ADD a dump is writing g_traceCopy
+extern uint32_t g_traceStartClock;           // PERF ADD read_clock() when the trace was started or reset
+extern uint64_t g_traceStartStamp;           // PERF ADD TRACE_STAMP() at the same moment
+extern SlotPtr g_mailbox_stash[MAXMBOX];     // PERF ADD reserved slots not in use right now
+extern int g_mailbox_stashCount[MAXMBOX];    // PERF ADD length of g_mailbox_stash
+extern const int g_slotClassSize[SLOT_CLASS_COUNT];  // PERF ADD payload bytes per class
+extern SlabPage g_slabPages[SLAB_PAGES];     // PERF ADD per-page slab bookkeeping
+extern int g_slabPartial[SLOT_CLASS_COUNT];  // PERF ADD pages of each class with a free slot, -1 if none
+extern int g_slabFreePage;                   // PERF ADD head of the free page pool, -1 if empty
+extern int g_slabFreePageCount;              // PERF ADD pages in the free page pool
+extern int g_slabClassFree[SLOT_CLASS_COUNT];    // PERF ADD free slots in the pages of each class
+extern WaitingProcessPtr g_poolWaitHead;     // PERF ADD senders waiting for the shared slot pool
+extern WaitingProcessPtr g_poolWaitTail;     // PERF ADD
+extern int g_poolWoken[SLOT_CLASS_COUNT];    // PERF ADD pool waiters woken that have not retried yet
+extern int g_clockTicks;                     // PERF ADD clock interrupts seen by the messaging layer
+extern int g_timerWheel[TIMER_WHEEL_BUCKETS];    // PERF ADD first timer node in each bucket, -1 if none
+extern TimerNode g_timerNode[TIMER_NODES];   // PERF ADD wheel links of every timer
+extern int g_timersArmed;                    // PERF ADD number of armed timers
+extern PeriodicTimer g_periodicTimer[MAX_PERIODIC_TIMERS];  // PERF ADD
+extern int g_freeTimerStack[MAX_PERIODIC_TIMERS];   // PERF ADD free periodic timer indexes
+extern int g_freeTimerCount;                 // PERF ADD number of free periodic timer indexes
+extern MailboxRing g_mailboxRing[MAXMBOX];   // PERF ADD ring storage of each mailbox
+extern unsigned char g_ringArena[RING_ARENA_SIZE];  // PERF ADD backing store of ring mailboxes
+extern int g_ringFirst;                      // PERF ADD ring mailbox with the lowest offset, -1 if none
+extern MailboxMulticast g_mailboxMcast[MAXMBOX];    // PERF ADD multicast mailboxes and their subscriptions
 extern MsgProcEntry g_msgProc[MAXPROC];      // TEST05 ADD One waiting node per process
 extern WaitingProcess g_waitNode[MAXPROC];   // TEST05 ADD
+extern WaitingProcess g_anyNode[MAXPROC][MAX_RECEIVE_ANY];  // PERF ADD one receive queue node per mailbox of a mailbox_receive_any call
 extern WaitingProcessPtr g_waitRecvHead[MAXMBOX];   // TEST05 ADD mailbox wait queues receiver head
 extern WaitingProcessPtr g_waitRecvTail[MAXMBOX];   // TEST05 ADD mailbox wait queues receiver tail
 extern WaitingProcessPtr g_waitSendHead[MAXMBOX];   // TEST05 ADD mailbox wait queues sender head
 extern WaitingProcessPtr g_waitSendTail[MAXMBOX];   // TEST05 ADD mailbox wait queues sender tail
 extern SlotPtr g_slotTail[MAXMBOX];          // TEST05 ADD mailbox slot tail for FIFO
+extern SlotPtr g_slotLaneTail[MAXMBOX][MESSAGE_LANES];  // PERF ADD last queued slot of each lane
+extern int g_mailbox_wakePolicy[MAXMBOX];    // PERF ADD MBOX_WAKE_FIFO or MBOX_WAKE_PRIORITY
+extern WaitingProcessPtr g_waitRecvLevelTail[MAXMBOX][WAKE_LEVELS];   // PERF ADD last receiver of each wake priority
+extern WaitingProcessPtr g_waitSendLevelTail[MAXMBOX][WAKE_LEVELS];   // PERF ADD last sender of each wake priority
+extern int g_wakePriorityPid[MAXPROC];       // PERF ADD pid that set the wake priority, by pid bucket
+extern int g_wakePriority[MAXPROC];          // PERF ADD wake priority set by that pid
+extern int g_freeMboxQueue[MAXMBOX];         // PERF ADD free mailbox index ring (FIFO)
+extern int g_freeMboxHead;                   // PERF ADD next index handed out by mailbox_create
+extern int g_freeMboxCount;                  // PERF ADD number of free mailbox indexes
+extern int g_pidBucket[MAXPROC];             // PERF ADD pid hash buckets, head entry index or -1
+extern int g_freeProcStack[MAXPROC];         // PERF ADD free MsgProcEntry indexes
+extern int g_freeProcCount;                  // PERF ADD number of free MsgProcEntry indexes
 
 /* ------------------------- Helper Prototypes ----------------------------- */
 
 void init_slot_freelist(void);       // TEST03 ADD
-SlotPtr allocate_slot(void);         // TEST03 ADD
+SlotPtr allocate_slot(int mboxIndex);    // TEST03 ADD PERF ALTER charged to a mailbox, NULL if at quota or pool empty
+int slot_quota_full(int mboxIndex);      // PERF ADD mailbox holds as many slots as its quota allows
+int slot_pool_room(int slotClass);       // PERF ADD slots of a class the shared pool can hand out
+int slot_pool_empty(int mboxIndex);      // PERF ADD no stash slot and no pool slot for this mailbox
+int slot_quota_set(int mboxIndex, int minSlots, int maxSlots);  // PERF ADD -1 if the pool cannot cover minSlots
+void slot_quota_reset(int mboxIndex);    // PERF ADD release the reservation of a freed mailbox
+void stats_count_send(int mboxIndex, int result, int msgSize);     // PERF ADD count a finished send
+void stats_count_receive(int mboxIndex, int result);               // PERF ADD count a finished receive
+void stats_note_depth(int mboxIndex);    // PERF ADD keep the peak depth after a message is queued
+void latency_start(MsgProcEntry* me);                              // PERF ADD note when me blocked, the first time only
+void latency_read(int mboxIndex, mailbox_latency_t* latency);       // PERF ADD copy a histogram and work out its percentiles
+void trace_event(int event, int pid, int mboxId, int size);        // PERF ADD append one record to the event trace
+void trace_block(MsgProcEntry* me);      // PERF ADD trace a block on the mailbox me waits on
+void trace_unblock(int pid);             // PERF ADD trace a wake, before the unblock call
+int slot_class_for_size(int slotSize);   // PERF ADD smallest class that holds slotSize bytes
+SlotPtr slot_from_message(void* pMsg);   // PERF ADD slot that owns a message buffer, NULL if not a slot
 void free_slot(SlotPtr s);           // TEST03 ADD
 void init_mailboxes(void);           // TEST03 ADD
 void init_proc_table(void);          // CLEANUP ADD
+int mbox_alloc_index(void);          // PERF ADD pop a free mailbox index, -1 if table full
+void mbox_release_index(int mboxIndex);  // PERF ADD advance generation and queue index for reuse
+int mbox_index(int mboxId);          // PERF ADD table index for a live id, -1 if invalid or stale
 
 void waitq_push(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr n);       // TEST05 ADD
 WaitingProcessPtr waitq_pop(WaitingProcessPtr* head, WaitingProcessPtr* tail);                // TEST05 ADD
-void slot_enqueue(int mboxId, SlotPtr s);                                                     // TEST05 ADD
-SlotPtr slot_dequeue(int mboxId);                                                             // TEST05 ADD
+void waitq_remove(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr n);     // PERF ADD
+void waitq_push_priority(WaitingProcessPtr* head, WaitingProcessPtr* tail, WaitingProcessPtr* levelTails, WaitingProcessPtr n);  // PERF ADD behind the waiters of equal or higher priority
+void recvq_push(int mboxIndex, WaitingProcessPtr n);                                          // PERF ADD queue a receiver by the mailbox wake policy
+void sendq_push(int mboxIndex, WaitingProcessPtr n);                                          // PERF ADD queue a sender by the mailbox wake policy
+int wake_priority(int pid);                                                                   // PERF ADD wake priority of pid, LOWEST_PRIORITY if never set
+void slot_enqueue(int mboxIndex, SlotPtr s, int lane);                                        // TEST05 ADD PERF ALTER behind the slots of equal or higher lanes
+SlotPtr slot_dequeue(int mboxIndex);                                                          // TEST05 ADD
+int ring_reserve(int mboxIndex, int slots, int slotSize);                                     // PERF ADD first-fit ring storage, -1 if no room
+void ring_release(int mboxIndex);                                                             // PERF ADD give the ring storage back
+void ring_push(int mboxIndex, void* pMsg, int msgSize);                                       // PERF ADD append one message, caller checks capacity
+int ring_peek_size(int mboxIndex);                                                            // PERF ADD size of the oldest message, caller checks count
+void ring_pop(int mboxIndex, void* pMsg);                                                     // PERF ADD copy out and drop the oldest message
+void mcast_subscribe(int subIndex, int mboxIndex);                                            // PERF ADD link a subscription, it starts at the spare slot
+int mcast_unsubscribe(int subIndex);                                                          // PERF ADD unlink a subscription, returns # of message slots freed
+void mcast_advance(int subIndex);                                                             // PERF ADD move the cursor past the message it is on
+void mcast_mark_waiting(int subIndex);                                                        // PERF ADD list a subscription that has a blocked receiver
+int mcast_reclaim(int mboxIndex);                                                             // PERF ADD free received head slots, returns # freed
 
 int device_id_from_param(char deviceId[32]);                                                  // TEST05 FIX ADD
 MsgProcEntry* mp_for_pid(int pid);           // TEST10 ADD helper to get MsgProcEntry pointer for a given pid
 MsgProcEntry* mp_self(void);                 // TEST10 ADD helper to get current process's MsgProcEntry pointer
 WaitingProcessPtr wp_for_pid(int pid);       // TEST10 ADD helper to get WaitingProcessPtr for a given pid
+MsgProcEntry* mp_attach(int pid);            // PERF ADD get or create the entry for pid before blocking
+void mp_detach(MsgProcEntry* me);            // PERF ADD release the entry once the blocking call is done
+MsgProcEntry* mp_for_node(WaitingProcessPtr node);  // PERF ADD entry that owns a wait queue node
+WaitingProcessPtr wp_for_entry(MsgProcEntry* me);   // PERF ADD reset and return the wait node of an entry
+void any_wait_claim(WaitingProcessPtr node);        // PERF ADD a receive_any caller woken through node leaves its other queues
+void any_wait_cancel(MsgProcEntry* me);             // PERF ADD take a receive_any caller off all its queues
+void timer_arm(MsgProcEntry* me, int deadline);     // PERF ADD time out the blocked call of me at tick deadline
+void timer_cancel(MsgProcEntry* me);                // PERF ADD disarm the timeout, if any
+void timer_tick(void);                              // PERF ADD advance the clock one tick and wake expired waiters
+int periodic_timer_alloc(int periodTicks);          // PERF ADD start a periodic timer, -1 if none left
+int periodic_timer_release(int timerIndex);         // PERF ADD stop a periodic timer, returns the pid waiting on it or -1
 
 void prepare_blocked_sender(MsgProcEntry* me, int mboxId, void* pMsg, int msg_size);          // CLEANUP ADD
 void prepare_blocked_receiver(MsgProcEntry* me, int mboxId, void* pMsg, int msg_size);        // CLEANUP ADD
@@ -10,9 +10,14 @@
 * MessagingTest16
 *
 * Global slot pool exhaustion test. Uses two mailboxes so that exhaustion
-* must come from the global pool, not per-mailbox limits. The expected
-* outcome is that the system halts via stop(1) when the pool is exhausted.
-* If this test reaches k_exit, the implementation failed to halt.
+* must come from the global pool, not per-mailbox limits. Once the pool is
+* exhausted, a non-blocking send returns -2 instead of halting the system.
+* Receiving one message gives its slot back to the pool, so the next send
+* goes through again.
+*
+* The big mailbox uses MAX_MESSAGE slots: smaller slot size classes fit more
+* slots in the same pool, so only full-size slots are sure to run out before
+* MAXSLOTS messages are queued.
 *
 *********************************************************************************/
 int MessagingEntryPoint(void* pArgs)
@@ -21,11 +26,12 @@ int MessagingEntryPoint(void* pArgs)
 	int smallMailboxId;
 	char* testName = GetTestName(__FILE__);
 	int sendCount = 0;
+	int result;
 	char message[32];
 
 	console_output(FALSE, "\n%s: started\n", testName);
 
-	bigMailboxId = mailbox_create(MAXSLOTS, sizeof(message));
+	bigMailboxId = mailbox_create(MAXSLOTS, MAX_MESSAGE);
 	console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, bigMailboxId);
 
 	smallMailboxId = mailbox_create(5, sizeof(message));
@@ -46,23 +52,36 @@ int MessagingEntryPoint(void* pArgs)
 		sendCount++;
 	}
 
-	/* Fill the big mailbox. The system should halt via stop(1) when
-	 * the global slot pool is exhausted. */
+	/* Fill the big mailbox until the global slot pool is exhausted. */
 	while (1)
 	{
 		sprintf(message, "Slot msg %d", sendCount);
-		mailbox_send(bigMailboxId, message, (int)strlen(message) + 1, FALSE);
+		result = mailbox_send(bigMailboxId, message, (int)strlen(message) + 1, FALSE);
+		if (result != 0)
+		{
+			break;
+		}
 		sendCount++;
 
 		if (sendCount == MAXSLOTS - 10)
 		{
-			console_output(FALSE, "%s: Sent %d messages - system should be halting soon\n",
+			console_output(FALSE, "%s: Sent %d messages - slot pool should run out soon\n",
 				testName, sendCount);
 		}
 	}
+	console_output(FALSE, "%s: send returned %d after %d messages\n", testName, result, sendCount);
+
+	/* One receive from the big mailbox gives a full-size slot back to the pool. */
+	result = mailbox_receive(bigMailboxId, message, sizeof(message), FALSE);
+	console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+
+	sprintf(message, "Slot msg %d", sendCount);
+	result = mailbox_send(bigMailboxId, message, (int)strlen(message) + 1, FALSE);
+	console_output(FALSE, "%s: send after the receive returned %d\n", testName, result);
+
+	mailbox_free(bigMailboxId);
+	mailbox_free(smallMailboxId);
 
-	/* Should never reach here. */
-	console_output(FALSE, "%s: FAILED - system did not halt on slot exhaustion\n", testName);
-	k_exit(1);
-	return 1;
+	k_exit(0);
+	return 0;
 }
\ No newline at end of file
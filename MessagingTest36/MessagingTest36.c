@@ -0,0 +1,92 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+/*********************************************************************************
+*
+* MessagingTest36 - Stale Mailbox Id After Free and Reuse
+*
+* Creates mailboxes until the mailbox table is full, frees one of them, and
+* creates one more mailbox. With the table full, the only free table entry is
+* the one just released, so the new mailbox reuses it.
+*
+* The new mailbox must get a different id than the freed one. Sends, receives
+* and frees through the old (stale) id must fail with -1 and must not touch
+* the new mailbox, while the new id works normally.
+*
+* Tests generation-tagged mailbox ids: a freed id is never handed out again
+* for a later mailbox, so a stale handle cannot reach the new owner.
+*
+* Expected: New id differs from the stale id. All stale-id operations return
+*           -1. Send and receive on the new id succeed.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int mbox_id;
+    int staleId = -1;
+    int newId;
+    int createCount = 0;
+    int result;
+    char message[32];
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* Fill the mailbox table, remembering one id in the middle. */
+    while ((mbox_id = mailbox_create(1, sizeof(message))) >= 0)
+    {
+        if (createCount == 20)
+        {
+            staleId = mbox_id;
+        }
+        createCount++;
+    }
+    console_output(FALSE, "%s: created %d mailboxes before the table was full\n", testName, createCount);
+
+    result = mailbox_free(staleId);
+    console_output(FALSE, "%s: mailbox_free(%d) returned %d\n", testName, staleId, result);
+
+    newId = mailbox_create(1, sizeof(message));
+    console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, newId);
+
+    if (newId >= 0 && newId != staleId)
+    {
+        console_output(FALSE, "%s: Reused table entry has a new id: PASSED\n", testName);
+    }
+    else
+    {
+        console_output(FALSE, "%s: Reused table entry has a new id: FAILED\n", testName);
+    }
+
+    strcpy(message, "Stale");
+    result = mailbox_send(staleId, message, (int)strlen(message) + 1, FALSE);
+    console_output(FALSE, "%s: mailbox_send on stale id returned %d: %s\n", testName, result,
+        result == -1 ? "PASSED" : "FAILED");
+
+    result = mailbox_receive(staleId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: mailbox_receive on stale id returned %d: %s\n", testName, result,
+        result == -1 ? "PASSED" : "FAILED");
+
+    result = mailbox_free(staleId);
+    console_output(FALSE, "%s: mailbox_free on stale id returned %d: %s\n", testName, result,
+        result == -1 ? "PASSED" : "FAILED");
+
+    strcpy(message, "Fresh");
+    result = mailbox_send(newId, message, (int)strlen(message) + 1, FALSE);
+    console_output(FALSE, "%s: mailbox_send on new id returned %d: %s\n", testName, result,
+        result == 0 ? "PASSED" : "FAILED");
+
+    message[0] = '\0';
+    result = mailbox_receive(newId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: mailbox_receive on new id returned %d, message '%s': %s\n", testName, result,
+        message, (result == 6 && strcmp(message, "Fresh") == 0) ? "PASSED" : "FAILED");
+
+    k_exit(0);
+
+    return 0;
+} /* MessagingEntryPoint */
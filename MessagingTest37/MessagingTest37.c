@@ -0,0 +1,107 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define SMALL_MAILBOXES     2
+
+/*********************************************************************************
+*
+* MessagingTest37 - Small Message Slot Capacity
+*
+* Creates two mailboxes of MAXSLOTS slots each with a slot size of sizeof(int),
+* the same shape as the device mailboxes. Fills both with non-blocking sends,
+* so 2 * MAXSLOTS small messages are queued at once. Then queues a message
+* in a MAX_MESSAGE mailbox, and drains everything in order.
+*
+* Tests the slot size classes: small slots take a fraction of the memory of a
+* full-size slot, so the pool holds more small messages than MAXSLOTS.
+*
+* Expected: All 2 * MAXSLOTS sends return 0. Every receive returns 4 bytes
+*           holding the value sent, in FIFO order. The full-size message
+*           is sent and received intact.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    int smallIds[SMALL_MAILBOXES];
+    int bigId;
+    int sendFailures = 0;
+    int receiveFailures = 0;
+    int result;
+    int value;
+    char bigMessage[MAX_MESSAGE];
+    char bigReply[MAX_MESSAGE];
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    for (int m = 0; m < SMALL_MAILBOXES; m++)
+    {
+        smallIds[m] = mailbox_create(MAXSLOTS, sizeof(int));
+        console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, smallIds[m]);
+    }
+    bigId = mailbox_create(1, MAX_MESSAGE);
+    console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, bigId);
+
+    /* Queue MAXSLOTS small messages in each mailbox. */
+    for (int m = 0; m < SMALL_MAILBOXES; m++)
+    {
+        for (int i = 0; i < MAXSLOTS; i++)
+        {
+            value = m * MAXSLOTS + i;
+            result = mailbox_send(smallIds[m], &value, sizeof(value), FALSE);
+            if (result != 0)
+            {
+                sendFailures++;
+            }
+        }
+    }
+    console_output(FALSE, "%s: queued %d small messages, %d sends failed\n",
+        testName, SMALL_MAILBOXES * MAXSLOTS - sendFailures, sendFailures);
+
+    /* A full-size message still fits while the small messages are queued. */
+    memset(bigMessage, 'A', sizeof(bigMessage));
+    result = mailbox_send(bigId, bigMessage, sizeof(bigMessage), FALSE);
+    console_output(FALSE, "%s: full-size send returned %d\n", testName, result);
+
+    for (int m = 0; m < SMALL_MAILBOXES; m++)
+    {
+        for (int i = 0; i < MAXSLOTS; i++)
+        {
+            value = -1;
+            result = mailbox_receive(smallIds[m], &value, sizeof(value), FALSE);
+            if (result != sizeof(value) || value != m * MAXSLOTS + i)
+            {
+                receiveFailures++;
+            }
+        }
+    }
+
+    memset(bigReply, 0, sizeof(bigReply));
+    result = mailbox_receive(bigId, bigReply, sizeof(bigReply), FALSE);
+    console_output(FALSE, "%s: full-size receive returned %d\n", testName, result);
+
+    if (sendFailures == 0 && receiveFailures == 0 &&
+        result == MAX_MESSAGE && memcmp(bigMessage, bigReply, sizeof(bigReply)) == 0)
+    {
+        console_output(FALSE, "%s: More than MAXSLOTS small messages queued and received in order: PASSED\n", testName);
+    }
+    else
+    {
+        console_output(FALSE, "%s: FAILED (send failures = %d, receive failures = %d)\n",
+            testName, sendFailures, receiveFailures);
+    }
+
+    for (int m = 0; m < SMALL_MAILBOXES; m++)
+    {
+        mailbox_free(smallIds[m]);
+    }
+    mailbox_free(bigId);
+
+    k_exit(0);
+    return 0;
+}
@@ -0,0 +1,219 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int AcquireChild(char* strArgs);
+int ReserveChild(char* strArgs);
+int DrainChild(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest38 - Zero-Copy Reserve/Commit and Acquire/Release
+*
+* Phase 1 - Non-blocking: the parent reserves all 3 slots of a mailbox, writes
+*           each message in place and commits it. A 4th reserve returns -2.
+*           The messages are then acquired in FIFO order, read in place and
+*           released.
+* Phase 2 - Blocking acquire: Child1 (priority 4) blocks in acquire on the
+*           empty mailbox. Child2 (priority 3) reserves and commits a message,
+*           which wakes Child1.
+* Phase 3 - Blocking reserve: the 1-slot mailbox is full. Child3 (priority 4)
+*           blocks in reserve. Child4 (priority 3) acquires the queued message,
+*           which hands the freed slot to Child3. Child3 commits its message
+*           and Child4 acquires it next.
+* Phase 4 - Invalid use: commit of a pointer that is not a slot, a second
+*           release of the same slot, reserve on a zero-slot mailbox and commit
+*           after the mailbox was freed all return -1.
+*
+* Expected: Every message is read back intact in order; the error cases
+*           return the documented codes.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    int kidpid, status;
+    int result;
+    void* buffers[4];
+    void* pMsg;
+    char notSlot[16];
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: non-blocking reserve/commit and acquire/release --- */
+    console_output(FALSE, "\n%s: Phase 1 - Non-blocking reserve and acquire\n", testName);
+
+    mailboxId = mailbox_create(3, 32);
+    console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, mailboxId);
+
+    for (int i = 0; i < 4; i++)
+    {
+        result = mailbox_send_reserve(mailboxId, 16, &buffers[i], FALSE);
+        console_output(FALSE, "%s: reserve %d returned %d\n", testName, i, result);
+        if (result == 0)
+        {
+            sprintf((char*)buffers[i], "In place %d", i);
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_send_commit(mailboxId, buffers[i]);
+        console_output(FALSE, "%s: commit %d returned %d\n", testName, i, result);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_receive_acquire(mailboxId, &pMsg, FALSE);
+        console_output(FALSE, "%s: acquire returned %d, message '%s'\n", testName, result,
+            result >= 0 ? (char*)pMsg : "");
+        result = mailbox_receive_release(mailboxId, pMsg);
+        console_output(FALSE, "%s: release returned %d\n", testName, result);
+    }
+    result = mailbox_receive_acquire(mailboxId, &pMsg, FALSE);
+    console_output(FALSE, "%s: acquire on empty mailbox returned %d\n", testName, result);
+
+    /* --- Phase 2: blocking acquire --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocking acquire\n", testName);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, AcquireChild, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, ReserveChild, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    for (int i = 0; i < 2; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: blocking reserve --- */
+    console_output(FALSE, "\n%s: Phase 3 - Blocking reserve\n", testName);
+
+    mailboxId = mailbox_create(1, 32);
+    result = mailbox_send(mailboxId, "Queued first", 13, FALSE);
+    console_output(FALSE, "%s: send to fill the mailbox returned %d\n", testName, result);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child3", testName);
+    kidpid = k_spawn(nameBuffer, ReserveChild, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child4", testName);
+    kidpid = k_spawn(nameBuffer, DrainChild, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    for (int i = 0; i < 2; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+
+    /* --- Phase 4: invalid use --- */
+    console_output(FALSE, "\n%s: Phase 4 - Invalid use\n", testName);
+
+    result = mailbox_send_commit(mailboxId, notSlot);
+    console_output(FALSE, "%s: commit of a non-slot buffer returned %d\n", testName, result);
+
+    mailbox_send(mailboxId, "Release twice", 14, FALSE);
+    mailbox_receive_acquire(mailboxId, &pMsg, FALSE);
+    result = mailbox_receive_release(mailboxId, pMsg);
+    console_output(FALSE, "%s: first release returned %d\n", testName, result);
+    result = mailbox_receive_release(mailboxId, pMsg);
+    console_output(FALSE, "%s: second release returned %d\n", testName, result);
+
+    result = mailbox_send_reserve(mailboxId, 16, &pMsg, FALSE);
+    console_output(FALSE, "%s: reserve before free returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+    result = mailbox_send_commit(mailboxId, pMsg);
+    console_output(FALSE, "%s: commit after mailbox_free returned %d\n", testName, result);
+
+    mailboxId = mailbox_create(0, 32);
+    result = mailbox_send_reserve(mailboxId, 16, &pMsg, FALSE);
+    console_output(FALSE, "%s: reserve on zero-slot mailbox returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* AcquireChild
+*
+* Blocks in mailbox_receive_acquire until a message arrives, then reads it in
+* place and releases the slot.
+*********************************************************************************/
+int AcquireChild(char* strArgs)
+{
+    void* pMsg;
+    int result;
+
+    console_output(FALSE, "%s: started, acquiring\n", strArgs);
+    result = mailbox_receive_acquire(mailboxId, &pMsg, TRUE);
+    console_output(FALSE, "%s: acquire returned %d, message '%s'\n", strArgs, result,
+        result >= 0 ? (char*)pMsg : "");
+    result = mailbox_receive_release(mailboxId, pMsg);
+    console_output(FALSE, "%s: release returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* ReserveChild
+*
+* Reserves a slot (blocking), writes its name into it and commits it.
+*********************************************************************************/
+int ReserveChild(char* strArgs)
+{
+    void* pMsg;
+    int result;
+
+    console_output(FALSE, "%s: started, reserving\n", strArgs);
+    result = mailbox_send_reserve(mailboxId, 32, &pMsg, TRUE);
+    console_output(FALSE, "%s: reserve returned %d\n", strArgs, result);
+    if (result == 0)
+    {
+        sprintf((char*)pMsg, "From Child%d", GetChildNumber(strArgs));
+        result = mailbox_send_commit(mailboxId, pMsg);
+        console_output(FALSE, "%s: commit returned %d\n", strArgs, result);
+    }
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* DrainChild
+*
+* Acquires and releases two messages from the 1-slot mailbox.
+*********************************************************************************/
+int DrainChild(char* strArgs)
+{
+    void* pMsg;
+    int result;
+
+    console_output(FALSE, "%s: started, draining\n", strArgs);
+    for (int i = 0; i < 2; i++)
+    {
+        result = mailbox_receive_acquire(mailboxId, &pMsg, TRUE);
+        console_output(FALSE, "%s: acquire returned %d, message '%s'\n", strArgs, result,
+            result >= 0 ? (char*)pMsg : "");
+        result = mailbox_receive_release(mailboxId, pMsg);
+        console_output(FALSE, "%s: release returned %d\n", strArgs, result);
+    }
+
+    k_exit(-3);
+    return 0;
+}
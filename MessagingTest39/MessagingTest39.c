@@ -0,0 +1,199 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define BATCH_MAX   8
+
+int BatchReceiver(char* strArgs);
+int BatchSender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest39 - Batch Send and Receive
+*
+* Phase 1 - Non-blocking: send_batch of 8 messages to a 5-slot mailbox sends 5.
+*           receive_batch of up to 8 returns those 5 in order. An empty batch
+*           receive returns -2 and a zero-count batch returns 0.
+* Phase 2 - Zero-slot rendezvous: the parent send_batch blocks on its first
+*           message. Child1 (priority 4) receive_batch takes that one message
+*           from the blocked sender; the rest of the parent batch has no
+*           receiver, so each side transfers exactly 1.
+* Phase 3 - Admitting blocked senders: a 2-slot mailbox is full and Child2
+*           (priority 4) blocks in send_batch of 3. The parent receive_batch
+*           takes the 2 queued messages; the first freed slot admits Child2's
+*           blocked message, which the same batch receives as the 3rd. Child2
+*           then queues its last 2 messages.
+*
+* Expected: Batch counts and message order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char messages[BATCH_MAX][16];
+    void* pMsgs[BATCH_MAX];
+    int sizes[BATCH_MAX];
+    int kidpid, status;
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+    for (int i = 0; i < BATCH_MAX; i++)
+    {
+        pMsgs[i] = messages[i];
+    }
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: non-blocking batches --- */
+    console_output(FALSE, "\n%s: Phase 1 - Non-blocking batches\n", testName);
+
+    mailboxId = mailbox_create(5, 16);
+    console_output(FALSE, "%s: mailbox_create returned id = %d\n", testName, mailboxId);
+
+    for (int i = 0; i < BATCH_MAX; i++)
+    {
+        sprintf(messages[i], "Batch %d", i);
+        sizes[i] = (int)strlen(messages[i]) + 1;
+    }
+    result = mailbox_send_batch(mailboxId, pMsgs, sizes, BATCH_MAX, FALSE);
+    console_output(FALSE, "%s: send_batch of %d returned %d\n", testName, BATCH_MAX, result);
+
+    memset(messages, 0, sizeof(messages));
+    result = mailbox_receive_batch(mailboxId, pMsgs, 16, sizes, BATCH_MAX, FALSE);
+    console_output(FALSE, "%s: receive_batch of %d returned %d\n", testName, BATCH_MAX, result);
+    for (int i = 0; i < result; i++)
+    {
+        console_output(FALSE, "%s: message %d is '%s' (%d bytes)\n", testName, i, messages[i], sizes[i]);
+    }
+
+    result = mailbox_receive_batch(mailboxId, pMsgs, 16, sizes, BATCH_MAX, FALSE);
+    console_output(FALSE, "%s: receive_batch on empty mailbox returned %d\n", testName, result);
+    result = mailbox_send_batch(mailboxId, pMsgs, sizes, 0, FALSE);
+    console_output(FALSE, "%s: send_batch of 0 returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 2: zero-slot rendezvous --- */
+    console_output(FALSE, "\n%s: Phase 2 - Zero-slot rendezvous\n", testName);
+
+    mailboxId = mailbox_create(0, 16);
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, BatchReceiver, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    for (int i = 0; i < 3; i++)
+    {
+        sprintf(messages[i], "Rendezvous %d", i);
+        sizes[i] = (int)strlen(messages[i]) + 1;
+    }
+    result = mailbox_send_batch(mailboxId, pMsgs, sizes, 3, TRUE);
+    console_output(FALSE, "%s: blocking send_batch of 3 returned %d\n", testName, result);
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: batch receive admits a blocked sender --- */
+    console_output(FALSE, "\n%s: Phase 3 - Batch receive admits a blocked sender\n", testName);
+
+    mailboxId = mailbox_create(2, 16);
+    mailbox_send(mailboxId, "Queued 0", 9, FALSE);
+    mailbox_send(mailboxId, "Queued 1", 9, FALSE);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, BatchSender, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child2 runs first and blocks on the full mailbox */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child3", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    memset(messages, 0, sizeof(messages));
+    result = mailbox_receive_batch(mailboxId, pMsgs, 16, sizes, BATCH_MAX, FALSE);
+    console_output(FALSE, "%s: receive_batch of %d returned %d\n", testName, BATCH_MAX, result);
+    for (int i = 0; i < result; i++)
+    {
+        console_output(FALSE, "%s: message %d is '%s'\n", testName, i, messages[i]);
+    }
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    memset(messages, 0, sizeof(messages));
+    result = mailbox_receive_batch(mailboxId, pMsgs, 16, sizes, BATCH_MAX, FALSE);
+    console_output(FALSE, "%s: receive_batch of %d returned %d\n", testName, BATCH_MAX, result);
+    for (int i = 0; i < result; i++)
+    {
+        console_output(FALSE, "%s: message %d is '%s'\n", testName, i, messages[i]);
+    }
+    mailbox_free(mailboxId);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* BatchReceiver
+*
+* Blocking receive_batch of up to 8 messages from the zero-slot mailbox.
+*********************************************************************************/
+int BatchReceiver(char* strArgs)
+{
+    char messages[BATCH_MAX][16];
+    void* pMsgs[BATCH_MAX];
+    int sizes[BATCH_MAX];
+    int result;
+
+    for (int i = 0; i < BATCH_MAX; i++)
+    {
+        pMsgs[i] = messages[i];
+    }
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive_batch(mailboxId, pMsgs, 16, sizes, BATCH_MAX, TRUE);
+    console_output(FALSE, "%s: blocking receive_batch returned %d\n", strArgs, result);
+    for (int i = 0; i < result; i++)
+    {
+        console_output(FALSE, "%s: message %d is '%s'\n", strArgs, i, messages[i]);
+    }
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* BatchSender
+*
+* Blocking send_batch of 3 messages to the full 2-slot mailbox.
+*********************************************************************************/
+int BatchSender(char* strArgs)
+{
+    char messages[3][16];
+    void* pMsgs[3];
+    int sizes[3];
+    int result;
+
+    for (int i = 0; i < 3; i++)
+    {
+        sprintf(messages[i], "Child2 %d", i);
+        pMsgs[i] = messages[i];
+        sizes[i] = (int)strlen(messages[i]) + 1;
+    }
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send_batch(mailboxId, pMsgs, sizes, 3, TRUE);
+    console_output(FALSE, "%s: blocking send_batch of 3 returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
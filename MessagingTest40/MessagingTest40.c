@@ -0,0 +1,159 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int RingSender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest40 - Ring Buffer Mailboxes
+*
+* Phase 1 - A 3-slot ring mailbox takes 3 messages; the 4th non-blocking send
+*           returns -2. A receive with a too-small buffer returns -1 and leaves
+*           the message queued. Ten send/receive rounds wrap the ring several
+*           times and keep FIFO order.
+* Phase 2 - Child1 (priority 4) blocks sending to the full ring. The parent
+*           receive frees an entry and admits Child1's message.
+* Phase 3 - Ring storage is reserved up front: a ring larger than the ring
+*           arena is refused, the space of a freed ring is reused, and the
+*           zero-copy calls reject ring mailboxes.
+*
+* Expected: Return codes and message order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[32];
+    char tiny[2];
+    void* pMsg;
+    int kidpid, status;
+    int result;
+    int ringA, ringB, ringC;
+    int inOrder = 1;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: FIFO and wrap-around --- */
+    console_output(FALSE, "\n%s: Phase 1 - FIFO and wrap-around\n", testName);
+
+    mailboxId = mailbox_create_ring(3, sizeof(message));
+    console_output(FALSE, "%s: mailbox_create_ring returned id = %d\n", testName, mailboxId);
+
+    for (int i = 0; i < 4; i++)
+    {
+        sprintf(message, "Ring %d", i);
+        result = mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+        console_output(FALSE, "%s: send '%s' returned %d\n", testName, message, result);
+    }
+
+    result = mailbox_receive(mailboxId, tiny, sizeof(tiny), FALSE);
+    console_output(FALSE, "%s: receive into a 2-byte buffer returned %d\n", testName, result);
+
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+
+    for (int round = 0; round < 10; round++)
+    {
+        int value = round;
+        int back = -1;
+
+        mailbox_send(mailboxId, &value, sizeof(value), FALSE);
+        mailbox_send(mailboxId, &value, sizeof(value), FALSE);
+        mailbox_receive(mailboxId, &back, sizeof(back), FALSE);
+        if (back != value) inOrder = 0;
+        mailbox_receive(mailboxId, &back, sizeof(back), FALSE);
+        if (back != value) inOrder = 0;
+    }
+    console_output(FALSE, "%s: wrap-around rounds %s\n", testName, inOrder ? "PASSED" : "FAILED");
+
+    /* --- Phase 2: blocked sender admitted into the ring --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocked sender\n", testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        sprintf(message, "Full %d", i);
+        mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+    }
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, RingSender, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    for (int i = 0; i < 4; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    /* --- Phase 3: ring storage --- */
+    console_output(FALSE, "\n%s: Phase 3 - Ring storage\n", testName);
+
+    result = mailbox_send_reserve(mailboxId, 4, &pMsg, FALSE);
+    console_output(FALSE, "%s: mailbox_send_reserve on a ring mailbox returned %d\n", testName, result);
+    result = mailbox_receive_acquire(mailboxId, &pMsg, FALSE);
+    console_output(FALSE, "%s: mailbox_receive_acquire on a ring mailbox returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+
+    result = mailbox_create_ring(MAXSLOTS, MAX_MESSAGE);
+    console_output(FALSE, "%s: ring of MAXSLOTS full-size entries returned %d\n", testName, result);
+    result = mailbox_create_ring(0, MAX_MESSAGE);
+    console_output(FALSE, "%s: ring of 0 entries returned %d\n", testName, result);
+
+    ringA = mailbox_create_ring(400, MAX_MESSAGE);
+    ringB = mailbox_create_ring(400, MAX_MESSAGE);
+    ringC = mailbox_create_ring(400, MAX_MESSAGE);
+    console_output(FALSE, "%s: two 400-entry rings %s, a third %s\n", testName,
+        (ringA >= 0 && ringB >= 0) ? "fit" : "do not fit", ringC >= 0 ? "fits" : "does not fit");
+
+    mailbox_free(ringA);
+    ringC = mailbox_create_ring(400, MAX_MESSAGE);
+    console_output(FALSE, "%s: after freeing the first, a new 400-entry ring %s\n", testName,
+        ringC >= 0 ? "fits" : "does not fit");
+
+    mailbox_free(ringB);
+    mailbox_free(ringC);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* RingSender
+*
+* Blocking send to the full ring mailbox.
+*********************************************************************************/
+int RingSender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send(mailboxId, "From Child1", 12, TRUE);
+    console_output(FALSE, "%s: blocking send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
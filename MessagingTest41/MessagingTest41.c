@@ -0,0 +1,170 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int QuotaSender(char* strArgs);
+void ShowUsage(char* testName, int mboxId);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest41 - Slot Reservations and Quotas
+*
+* Phase 1 - A 10-slot mailbox with a reservation of 2 and a quota of 4 takes 4
+*           non-blocking sends; the 5th returns -2 although the mailbox still
+*           has capacity. The usage report shows 4 slots held and 1 reject.
+* Phase 2 - Child1 (priority 4) blocks sending to the mailbox at its quota.
+*           The parent receive frees a slot and admits Child1's message; all 5
+*           messages come back in order.
+* Phase 3 - Reservations come out of the shared pool up front: a mailbox that
+*           reserves all but 100 of the full-size slots leaves too little for
+*           a second reservation, which fails and changes nothing. Lowering the first
+*           reservation to 0 lets the second one through.
+* Phase 4 - Invalid use: minimum above the quota or the capacity, negative
+*           counts, zero-slot and ring mailboxes, a NULL usage pointer and a
+*           freed mailbox all return -1.
+*
+* Expected: Return codes, usage counts and message order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[32];
+    int kidpid, status;
+    int result;
+    int bigA, bigB, other;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: quota backpressure --- */
+    console_output(FALSE, "\n%s: Phase 1 - Quota backpressure\n", testName);
+
+    mailboxId = mailbox_create(10, sizeof(message));
+    result = mailbox_set_quota(mailboxId, 2, 4);
+    console_output(FALSE, "%s: mailbox_set_quota(2, 4) returned %d\n", testName, result);
+    ShowUsage(testName, mailboxId);
+
+    for (int i = 0; i < 5; i++)
+    {
+        sprintf(message, "Quota %d", i);
+        result = mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+        console_output(FALSE, "%s: send '%s' returned %d\n", testName, message, result);
+    }
+    ShowUsage(testName, mailboxId);
+
+    /* --- Phase 2: blocked sender admitted when a slot comes back --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocked sender\n", testName);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, QuotaSender, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    for (int i = 0; i < 5; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    ShowUsage(testName, mailboxId);
+
+    /* --- Phase 3: reservations are taken from the pool --- */
+    console_output(FALSE, "\n%s: Phase 3 - Reservations\n", testName);
+
+    bigA = mailbox_create(MAXSLOTS, MAX_MESSAGE);
+    bigB = mailbox_create(MAXSLOTS, MAX_MESSAGE);
+    result = mailbox_set_quota(bigA, MAXSLOTS - 100, 0);
+    console_output(FALSE, "%s: reserving %d full-size slots returned %d\n", testName, MAXSLOTS - 100, result);
+    result = mailbox_set_quota(bigB, MAXSLOTS / 5, 0);
+    console_output(FALSE, "%s: a second reservation of %d returned %d\n", testName, MAXSLOTS / 5, result);
+    ShowUsage(testName, bigB);
+
+    result = mailbox_set_quota(bigA, 0, 0);
+    console_output(FALSE, "%s: dropping the first reservation returned %d\n", testName, result);
+    result = mailbox_set_quota(bigB, MAXSLOTS / 5, 0);
+    console_output(FALSE, "%s: the second reservation now returned %d\n", testName, result);
+    ShowUsage(testName, bigB);
+
+    mailbox_free(bigA);
+    mailbox_free(bigB);
+
+    /* --- Phase 4: invalid use --- */
+    console_output(FALSE, "\n%s: Phase 4 - Invalid use\n", testName);
+
+    result = mailbox_set_quota(mailboxId, 3, 2);
+    console_output(FALSE, "%s: minimum above the quota returned %d\n", testName, result);
+    result = mailbox_set_quota(mailboxId, 11, 0);
+    console_output(FALSE, "%s: minimum above the capacity returned %d\n", testName, result);
+    result = mailbox_set_quota(mailboxId, -1, 0);
+    console_output(FALSE, "%s: negative minimum returned %d\n", testName, result);
+    result = mailbox_get_usage(mailboxId, NULL);
+    console_output(FALSE, "%s: mailbox_get_usage with NULL returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+    result = mailbox_set_quota(mailboxId, 0, 4);
+    console_output(FALSE, "%s: quota on a freed mailbox returned %d\n", testName, result);
+
+    other = mailbox_create(0, sizeof(message));
+    result = mailbox_set_quota(other, 0, 4);
+    console_output(FALSE, "%s: quota on a zero-slot mailbox returned %d\n", testName, result);
+    mailbox_free(other);
+
+    other = mailbox_create_ring(4, sizeof(message));
+    result = mailbox_set_quota(other, 0, 4);
+    console_output(FALSE, "%s: quota on a ring mailbox returned %d\n", testName, result);
+    mailbox_free(other);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* ShowUsage
+*
+* Prints the usage report of a mailbox.
+*********************************************************************************/
+void ShowUsage(char* testName, int mboxId)
+{
+    mailbox_usage_t usage;
+
+    if (mailbox_get_usage(mboxId, &usage) == 0)
+    {
+        console_output(FALSE, "%s: usage capacity=%d queued=%d inUse=%d peak=%d min=%d quota=%d rejects=%d\n",
+            testName, usage.capacity, usage.queued, usage.slotsInUse, usage.slotsPeak,
+            usage.minReserved, usage.maxQuota, usage.quotaRejects);
+    }
+}
+
+/*********************************************************************************
+* QuotaSender
+*
+* Blocking send to the mailbox at its quota.
+*********************************************************************************/
+int QuotaSender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send(mailboxId, "From Child1", 12, TRUE);
+    console_output(FALSE, "%s: blocking send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,184 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define PRODUCERS           10
+#define MESSAGES_EACH       500         /* PRODUCERS * MESSAGES_EACH is twice MAXSLOTS */
+#define MAILBOX_SLOTS       (MAXSLOTS / 4)
+
+int Producer(char* strArgs);
+int QueuedMessages(void);
+
+int mailboxIds[PRODUCERS];
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest42 - Slot Pool Exhaustion Under Load
+*
+* Ten producers (priority 4) each make blocking sends of 500 full-size messages
+* to their own mailbox. Together the mailboxes hold more than MAXSLOTS, so
+* the shared slot pool runs dry part way through and the remaining producers
+* wait on it instead of halting the system.
+*
+* Phase 1 - Once each producer has finished or blocked, the pool is exhausted:
+*           not all messages could be queued, and a non-blocking send to
+*           another mailbox returns -2.
+* Phase 2 - The parent drains the mailboxes one after another with blocking
+*           receives. Every slot it frees lets a waiting producer go on, so
+*           all 5000 messages arrive, each mailbox in order.
+* Phase 3 - With the mailboxes drained, non-blocking sends spread over them
+*           fit exactly as many messages as were queued in Phase 1.
+*
+* Expected: No halt; message counts and order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[MAX_MESSAGE];
+    int kidpid, status, waitPid;
+    int finished = 0;
+    int result;
+    int queuedWhenDry, refill;
+    int received = 0, inOrder = 1;
+    int otherMailbox;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: producers run the pool dry --- */
+    console_output(FALSE, "\n%s: Phase 1 - Pool exhaustion\n", testName);
+
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        mailboxIds[i] = mailbox_create(MAILBOX_SLOTS, MAX_MESSAGE);
+    }
+    otherMailbox = mailbox_create(MAILBOX_SLOTS, MAX_MESSAGE);
+
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Producer%d", testName, i);
+        kidpid = k_spawn(nameBuffer, Producer, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        strncpy(childNames[kidpid], nameBuffer, 256);
+    }
+
+    /* Wait on a lower priority child so every producer runs until it blocks or
+       finishes; the producers whose messages all fit are reaped on the way */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    waitPid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[waitPid], nameBuffer, 256);
+    while ((kidpid = k_wait(&status)) != waitPid)
+    {
+        finished++;
+    }
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    console_output(FALSE, "%s: %d producers finished, %d are waiting for slots\n", testName,
+        finished, PRODUCERS - finished);
+
+    queuedWhenDry = QueuedMessages();
+    console_output(FALSE, "%s: %s messages are queued, the pool %s\n", testName,
+        queuedWhenDry < PRODUCERS * MESSAGES_EACH ? "not all" : "all",
+        queuedWhenDry < PRODUCERS * MESSAGES_EACH ? "is exhausted" : "did not run out");
+
+    result = mailbox_send(otherMailbox, "Other", 6, FALSE);
+    console_output(FALSE, "%s: non-blocking send to another mailbox returned %d\n", testName, result);
+
+    /* --- Phase 2: draining lets the producers finish --- */
+    console_output(FALSE, "\n%s: Phase 2 - Recovery\n", testName);
+
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        for (int n = 0; n < MESSAGES_EACH; n++)
+        {
+            char expected[32];
+
+            result = mailbox_receive(mailboxIds[i], message, sizeof(message), TRUE);
+            sprintf(expected, "P%d-%d", i, n);
+            if (result < 0 || strcmp(message, expected) != 0)
+                inOrder = 0;
+            else
+                received++;
+        }
+    }
+    console_output(FALSE, "%s: received %d of %d messages, order %s\n", testName,
+        received, PRODUCERS * MESSAGES_EACH, inOrder ? "PASSED" : "FAILED");
+
+    while (finished < PRODUCERS)
+    {
+        k_wait(&status);
+        finished++;
+    }
+    console_output(FALSE, "%s: all %d producers finished\n", testName, PRODUCERS);
+
+    /* --- Phase 3: the pool is whole again --- */
+    console_output(FALSE, "\n%s: Phase 3 - Pool refilled\n", testName);
+
+    refill = 0;
+    for (int i = 0; mailbox_send(mailboxIds[i], "Refill", 7, FALSE) == 0; i = (i + 1) % PRODUCERS)
+    {
+        refill++;
+    }
+    console_output(FALSE, "%s: the pool takes %s messages as in Phase 1\n", testName,
+        refill == queuedWhenDry ? "as many" : "a different number of");
+
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        mailbox_free(mailboxIds[i]);
+    }
+    mailbox_free(otherMailbox);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* QueuedMessages
+*
+* Sum of the messages queued in the producer mailboxes.
+*********************************************************************************/
+int QueuedMessages(void)
+{
+    mailbox_usage_t usage;
+    int total = 0;
+
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        if (mailbox_get_usage(mailboxIds[i], &usage) == 0)
+            total += usage.queued;
+    }
+    return total;
+}
+
+/*********************************************************************************
+* Producer
+*
+* Blocking sends of MESSAGES_EACH messages "P<producer>-<n>" to its mailbox.
+*********************************************************************************/
+int Producer(char* strArgs)
+{
+    char message[MAX_MESSAGE];
+    int producer = 0;
+
+    sscanf(strrchr(strArgs, 'r') + 1, "%d", &producer);
+
+    for (int n = 0; n < MESSAGES_EACH; n++)
+    {
+        memset(message, 0, sizeof(message));
+        sprintf(message, "P%d-%d", producer, n);
+        if (mailbox_send(mailboxIds[producer], message, sizeof(message), TRUE) != 0)
+        {
+            console_output(FALSE, "%s: send %d failed\n", strArgs, n);
+            break;
+        }
+    }
+
+    k_exit(-3);
+    return 0;
+}
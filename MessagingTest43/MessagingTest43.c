@@ -0,0 +1,179 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int Server(char* strArgs);
+int FreedServer(char* strArgs);
+
+int mailboxIds[3];
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest43 - Receive From Any of Several Mailboxes
+*
+* Phase 1 - Non-blocking: with a message only in the second of three
+*           mailboxes, mailbox_receive_any returns it with which = 1. With all
+*           three empty it returns -2. A stale id in the list, an empty list
+*           and a NULL which pointer return -1.
+* Phase 2 - Blocking: Child1 (priority 4) waits on two slotted mailboxes and a
+*           zero-slot mailbox. The parent sends to the third mailbox, which
+*           wakes Child1 and takes it off the other two queues: the next send
+*           to the first mailbox is queued, and a non-blocking send to the
+*           zero-slot mailbox finds no receiver and returns -2. Child1 then
+*           receives the queued message and the parent's blocking zero-slot
+*           send, reporting which mailbox each came from.
+* Phase 3 - Child2 (priority 4) waits on two mailboxes and the parent frees
+*           one of them. Child2 gets -1 with which pointing at the freed
+*           mailbox, is not signaled, and goes on to receive from the other.
+*
+* Expected: Return codes and which values as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[32];
+    int kidpid, status;
+    int result, which;
+    int staleIds[2];
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: non-blocking --- */
+    console_output(FALSE, "\n%s: Phase 1 - Non-blocking\n", testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        mailboxIds[i] = mailbox_create(5, sizeof(message));
+    }
+
+    mailbox_send(mailboxIds[1], "Second", 7, FALSE);
+    result = mailbox_receive_any(mailboxIds, 3, &which, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive_any returned %d, which = %d, message '%s'\n", testName, result, which, message);
+
+    result = mailbox_receive_any(mailboxIds, 3, &which, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive_any on empty mailboxes returned %d\n", testName, result);
+
+    staleIds[0] = mailboxIds[0];
+    staleIds[1] = mailbox_create(1, sizeof(message));
+    mailbox_free(staleIds[1]);
+    result = mailbox_receive_any(staleIds, 2, &which, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive_any with a stale id returned %d\n", testName, result);
+    result = mailbox_receive_any(mailboxIds, 0, &which, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive_any of 0 mailboxes returned %d\n", testName, result);
+    result = mailbox_receive_any(mailboxIds, 3, NULL, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive_any with NULL which returned %d\n", testName, result);
+
+    /* --- Phase 2: blocking on three mailboxes --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocking\n", testName);
+
+    mailbox_free(mailboxIds[1]);
+    mailboxIds[1] = mailbox_create(0, sizeof(message));
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, Server, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    result = mailbox_send(mailboxIds[2], "To third", 9, FALSE);
+    console_output(FALSE, "%s: send to the third mailbox returned %d\n", testName, result);
+    result = mailbox_send(mailboxIds[0], "To first", 9, FALSE);
+    console_output(FALSE, "%s: send to the first mailbox returned %d\n", testName, result);
+    result = mailbox_send(mailboxIds[1], "To zero-slot", 13, FALSE);
+    console_output(FALSE, "%s: non-blocking send to the zero-slot mailbox returned %d\n", testName, result);
+    result = mailbox_send(mailboxIds[1], "To zero-slot", 13, TRUE);
+    console_output(FALSE, "%s: blocking send to the zero-slot mailbox returned %d\n", testName, result);
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    /* --- Phase 3: a mailbox is freed while waiting --- */
+    console_output(FALSE, "\n%s: Phase 3 - Freed while waiting\n", testName);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child3", testName);
+    kidpid = k_spawn(nameBuffer, FreedServer, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child4", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    result = mailbox_free(mailboxIds[0]);
+    console_output(FALSE, "%s: mailbox_free of the first mailbox returned %d\n", testName, result);
+    result = mailbox_send(mailboxIds[2], "After free", 11, TRUE);
+    console_output(FALSE, "%s: send to the third mailbox returned %d\n", testName, result);
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    mailbox_free(mailboxIds[1]);
+    mailbox_free(mailboxIds[2]);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* Server
+*
+* Three blocking mailbox_receive_any calls over all three mailboxes.
+*********************************************************************************/
+int Server(char* strArgs)
+{
+    char message[32];
+    int result, which;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_receive_any(mailboxIds, 3, &which, message, sizeof(message), TRUE);
+        console_output(FALSE, "%s: receive_any returned %d, which = %d, message '%s'\n",
+            strArgs, result, which, result >= 0 ? message : "");
+    }
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* FreedServer
+*
+* Waits on the first and third mailboxes; the first is freed under it.
+*********************************************************************************/
+int FreedServer(char* strArgs)
+{
+    char message[32];
+    int ids[2];
+    int result, which;
+
+    ids[0] = mailboxIds[0];
+    ids[1] = mailboxIds[2];
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive_any(ids, 2, &which, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive_any returned %d, which = %d, signaled = %d\n",
+        strArgs, result, which, signaled());
+
+    result = mailbox_receive_any(ids + 1, 1, &which, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive_any returned %d, which = %d, message '%s'\n",
+        strArgs, result, which, result >= 0 ? message : "");
+
+    k_exit(-3);
+    return 0;
+}
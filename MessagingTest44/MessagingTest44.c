@@ -0,0 +1,175 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int TimedReceiver(char* strArgs);
+int TimeoutReporter(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest44 - Timed Send and Receive
+*
+* Phase 1 - mailbox_receive_timed on an empty zero-slot mailbox returns
+*           MAILBOX_TIMEOUT after at least the timeout. The receiver is off
+*           the queue afterwards: a non-blocking send finds no receiver and
+*           returns -2. A timeout of 0 does not block and returns -2.
+* Phase 2 - mailbox_send_timed to a full 1-slot mailbox returns
+*           MAILBOX_TIMEOUT. The timed-out message is not admitted later: one
+*           receive gets the original message and the next returns -2.
+* Phase 3 - Child1 (priority 4) waits up to 5 seconds on the zero-slot mailbox
+*           and the parent's send reaches it well before the deadline.
+* Phase 4 - Three children wait with timeouts of 300, 100 and 200 ms and time
+*           out in deadline order.
+* Phase 5 - A negative timeout returns -1.
+*
+* Expected: Return codes and timeout order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[32];
+    int timeouts[] = { 300, 100, 200 };
+    int kidpid, status;
+    int result;
+    DWORD startTime, endTime;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: receive times out --- */
+    console_output(FALSE, "\n%s: Phase 1 - Receive timeout\n", testName);
+
+    mailboxId = mailbox_create(0, sizeof(message));
+
+    startTime = read_clock();
+    result = mailbox_receive_timed(mailboxId, message, sizeof(message), 100);
+    endTime = read_clock();
+    console_output(FALSE, "%s: mailbox_receive_timed returned %d\n", testName, result);
+    console_output(FALSE, "%s: waited %s the timeout\n", testName,
+        endTime - startTime >= (100 - 20) * 1000 ? "at least" : "less than");
+
+    result = mailbox_send(mailboxId, "Nobody", 7, FALSE);
+    console_output(FALSE, "%s: non-blocking send returned %d\n", testName, result);
+    result = mailbox_receive_timed(mailboxId, message, sizeof(message), 0);
+    console_output(FALSE, "%s: mailbox_receive_timed with timeout 0 returned %d\n", testName, result);
+
+    /* --- Phase 2: send times out --- */
+    console_output(FALSE, "\n%s: Phase 2 - Send timeout\n", testName);
+
+    mailbox_free(mailboxId);
+    mailboxId = mailbox_create(1, sizeof(message));
+
+    mailbox_send(mailboxId, "First", 6, FALSE);
+    result = mailbox_send_timed(mailboxId, "Late", 5, 100);
+    console_output(FALSE, "%s: mailbox_send_timed returned %d\n", testName, result);
+
+    result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive returned %d\n", testName, result);
+
+    /* --- Phase 3: message arrives before the deadline --- */
+    console_output(FALSE, "\n%s: Phase 3 - Message before the deadline\n", testName);
+
+    mailbox_free(mailboxId);
+    mailboxId = mailbox_create(0, sizeof(message));
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, TimedReceiver, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    result = mailbox_send(mailboxId, "In time", 8, TRUE);
+    console_output(FALSE, "%s: blocking send returned %d\n", testName, result);
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    /* --- Phase 4: timeouts fire in deadline order --- */
+    console_output(FALSE, "\n%s: Phase 4 - Deadline order\n", testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Timeout%d", testName, timeouts[i]);
+        kidpid = k_spawn(nameBuffer, TimeoutReporter, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        strncpy(childNames[kidpid], nameBuffer, 256);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+
+    /* --- Phase 5: invalid timeout --- */
+    console_output(FALSE, "\n%s: Phase 5 - Invalid timeout\n", testName);
+
+    result = mailbox_receive_timed(mailboxId, message, sizeof(message), -1);
+    console_output(FALSE, "%s: mailbox_receive_timed with timeout -1 returned %d\n", testName, result);
+    result = mailbox_send_timed(mailboxId, "Bad", 4, -1);
+    console_output(FALSE, "%s: mailbox_send_timed with timeout -1 returned %d\n", testName, result);
+
+    mailbox_free(mailboxId);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* TimedReceiver
+*
+* Timed receive with a deadline far enough out that the parent's send wins.
+*********************************************************************************/
+int TimedReceiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive_timed(mailboxId, message, sizeof(message), 5000);
+    console_output(FALSE, "%s: mailbox_receive_timed returned %d, message '%s'\n",
+        strArgs, result, result >= 0 ? message : "");
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* TimeoutReporter
+*
+* Timed receive on the empty zero-slot mailbox. The timeout in ms is the
+* number after "Timeout" in the process name.
+*********************************************************************************/
+int TimeoutReporter(char* strArgs)
+{
+    char message[32];
+    int timeout = 0;
+    int result;
+    char* pTimeout = strstr(strArgs, "Timeout");
+
+    if (pTimeout != NULL)
+    {
+        sscanf(pTimeout + 7, "%d", &timeout);
+    }
+
+    result = mailbox_receive_timed(mailboxId, message, sizeof(message), timeout);
+    console_output(FALSE, "%s: mailbox_receive_timed returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
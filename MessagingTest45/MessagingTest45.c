@@ -0,0 +1,189 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int Sleeper(char* strArgs);
+int TimerWaiter(char* strArgs);
+
+int timerId;
+char childNames[MAXPROC][256];
+int timerIds[MAX_PERIODIC_TIMERS];
+
+/*********************************************************************************
+*
+* MessagingTest45 - k_sleep and Periodic Timers
+*
+* Phase 1 - Three children sleep 300, 100 and 200 ms. They wake in deadline
+*           order, each after at least its sleep time. k_sleep(0) returns 0
+*           at once and k_sleep(-1) returns -1.
+* Phase 2 - A 100 ms periodic timer is waited on five times. Each wait
+*           returns 1 and the five waits take about 500 ms in total.
+* Phase 3 - After sleeping through several periods of a 40 ms timer, one
+*           wait returns the number of expiries missed (at least 4).
+* Phase 4 - Child1 (priority 4) waits on a 10 second timer. A second waiter
+*           is refused with -1, and stopping the timer wakes Child1 with -1.
+* Phase 5 - A period of 0 and stale timer ids return -1. All
+*           MAX_PERIODIC_TIMERS timers can run at once and one more is refused.
+*
+* Expected: Wake order and return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    int sleeps[] = { 300, 100, 200 };
+    int kidpid, status;
+    int result, started;
+    int allOnes = 1;
+    DWORD startTime, endTime;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: k_sleep --- */
+    console_output(FALSE, "\n%s: Phase 1 - k_sleep\n", testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Sleep%d", testName, sleeps[i]);
+        kidpid = k_spawn(nameBuffer, Sleeper, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        strncpy(childNames[kidpid], nameBuffer, 256);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+
+    result = k_sleep(0);
+    console_output(FALSE, "%s: k_sleep(0) returned %d\n", testName, result);
+    result = k_sleep(-1);
+    console_output(FALSE, "%s: k_sleep(-1) returned %d\n", testName, result);
+
+    /* --- Phase 2: periodic timer --- */
+    console_output(FALSE, "\n%s: Phase 2 - Periodic timer\n", testName);
+
+    startTime = read_clock();
+    timerId = periodic_timer_start(100);
+    console_output(FALSE, "%s: periodic_timer_start returned %s\n", testName, timerId >= 0 ? "an id" : "an error");
+    for (int i = 0; i < 5; i++)
+    {
+        result = periodic_timer_wait(timerId);
+        if (result != 1) allOnes = 0;
+    }
+    endTime = read_clock();
+    console_output(FALSE, "%s: five waits %s\n", testName, allOnes ? "each returned 1" : "missed expiries");
+    console_output(FALSE, "%s: five periods took %s\n", testName,
+        (endTime - startTime >= 480 * 1000 && endTime - startTime < 700 * 1000) ? "about 500 ms" : "too long or too short");
+    periodic_timer_stop(timerId);
+
+    /* --- Phase 3: expiries counted while not waiting --- */
+    console_output(FALSE, "\n%s: Phase 3 - Missed expiries\n", testName);
+
+    timerId = periodic_timer_start(40);
+    k_sleep(200);
+    result = periodic_timer_wait(timerId);
+    console_output(FALSE, "%s: wait after 200 ms returned %s\n", testName, result >= 4 ? "at least 4" : "fewer than 4");
+    periodic_timer_stop(timerId);
+
+    /* --- Phase 4: stop while waiting --- */
+    console_output(FALSE, "\n%s: Phase 4 - Stop while waiting\n", testName);
+
+    timerId = periodic_timer_start(10000);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, TimerWaiter, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    result = periodic_timer_wait(timerId);
+    console_output(FALSE, "%s: second waiter returned %d\n", testName, result);
+    result = periodic_timer_stop(timerId);
+    console_output(FALSE, "%s: periodic_timer_stop returned %d\n", testName, result);
+
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    /* --- Phase 5: invalid args and capacity --- */
+    console_output(FALSE, "\n%s: Phase 5 - Invalid args and capacity\n", testName);
+
+    result = periodic_timer_start(0);
+    console_output(FALSE, "%s: periodic_timer_start(0) returned %d\n", testName, result);
+    result = periodic_timer_wait(timerId);
+    console_output(FALSE, "%s: periodic_timer_wait on a stopped timer returned %d\n", testName, result);
+    result = periodic_timer_stop(timerId);
+    console_output(FALSE, "%s: periodic_timer_stop on a stopped timer returned %d\n", testName, result);
+
+    started = 0;
+    for (int i = 0; i < MAX_PERIODIC_TIMERS; i++)
+    {
+        timerIds[i] = periodic_timer_start(1000 + i);
+        if (timerIds[i] >= 0) started++;
+    }
+    console_output(FALSE, "%s: started %d of %d timers\n", testName, started, MAX_PERIODIC_TIMERS);
+    result = periodic_timer_start(1000);
+    console_output(FALSE, "%s: one more periodic_timer_start returned %d\n", testName, result);
+    for (int i = 0; i < MAX_PERIODIC_TIMERS; i++)
+    {
+        periodic_timer_stop(timerIds[i]);
+    }
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* Sleeper
+*
+* Sleeps for the number of ms after "Sleep" in its name and checks the time.
+*********************************************************************************/
+int Sleeper(char* strArgs)
+{
+    int ms = 0;
+    int result;
+    char* pMs = strstr(strArgs, "Sleep");
+    DWORD startTime, endTime;
+
+    if (pMs != NULL)
+    {
+        sscanf(pMs + 5, "%d", &ms);
+    }
+
+    startTime = read_clock();
+    result = k_sleep(ms);
+    endTime = read_clock();
+    console_output(FALSE, "%s: k_sleep returned %d after %s its time\n", strArgs, result,
+        endTime - startTime >= (DWORD)ms * 1000 ? "at least" : "less than");
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* TimerWaiter
+*
+* Waits on the periodic timer, which the parent stops.
+*********************************************************************************/
+int TimerWaiter(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = periodic_timer_wait(timerId);
+    console_output(FALSE, "%s: periodic_timer_wait returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int ClockWaiter(char* strArgs);
+int PeriodicClock(char* strArgs);
+
+int clockStatus[3];
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest46 - Clock Ticks Broadcast to Every Waiter
+*
+* Phase 1 - Three children (priority 4) wait on the clock at the same time.
+*           All three wake on the same tick and see the same status. Each
+*           first wait returns 1.
+* Phase 2 - Child4 waits on the clock five times in a row; each wait returns
+*           1. It then sleeps 450 ms, and the next wait reports the ticks
+*           that passed meanwhile (at least 4).
+*
+* Expected: Return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    int kidpid, status;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: every waiter gets the tick --- */
+    console_output(FALSE, "\n%s: Phase 1 - Broadcast\n", testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child%d", testName, i + 1);
+        kidpid = k_spawn(nameBuffer, ClockWaiter, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+        strncpy(childNames[kidpid], nameBuffer, 256);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+    console_output(FALSE, "%s: the three waiters %s\n", testName,
+        (clockStatus[0] == clockStatus[1] && clockStatus[1] == clockStatus[2]) ? "woke on the same tick" : "woke on different ticks");
+
+    /* --- Phase 2: elapsed ticks --- */
+    console_output(FALSE, "\n%s: Phase 2 - Elapsed ticks\n", testName);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child4", testName);
+    kidpid = k_spawn(nameBuffer, PeriodicClock, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* ClockWaiter
+*
+* One wait on the clock; the status goes in clockStatus[child number - 1].
+*********************************************************************************/
+int ClockWaiter(char* strArgs)
+{
+    int status = 0;
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = wait_device("clock", &status);
+    clockStatus[GetChildNumber(strArgs) - 1] = status;
+    console_output(FALSE, "%s: wait_device returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* PeriodicClock
+*
+* Five back-to-back clock waits, then one after a 450 ms sleep.
+*********************************************************************************/
+int PeriodicClock(char* strArgs)
+{
+    int status;
+    int result;
+    int allOnes = 1;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    for (int i = 0; i < 5; i++)
+    {
+        result = wait_device("clock", &status);
+        if (result != 1) allOnes = 0;
+    }
+    console_output(FALSE, "%s: five waits %s\n", strArgs, allOnes ? "each returned 1" : "skipped ticks");
+
+    k_sleep(450);
+    result = wait_device("clock", &status);
+    console_output(FALSE, "%s: wait after sleeping returned %s\n", strArgs, result >= 4 ? "at least 4" : "fewer than 4");
+
+    k_exit(-3);
+    return 0;
+}
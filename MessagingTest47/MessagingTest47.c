@@ -0,0 +1,226 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int Receiver(char* strArgs);
+int Sender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+
+/*********************************************************************************
+*
+* MessagingTest47 - Priority-Ordered Wait Queues
+*
+* Each child (priority 4) sets its wake priority from the number after
+* "Wake" in its name and then blocks on the mailbox.
+*
+* Phase 1 - Five wake-priority-1 receivers block, then one wake-priority-5
+*           receiver. The parent sends six messages. On a FIFO mailbox the
+*           urgent receiver gets the 6th message; on a MBOX_WAKE_PRIORITY
+*           mailbox it gets the 1st.
+* Phase 2 - Receivers with wake priorities 1, 3, 5 and 3 block. The last one
+*           uses a timed receive and times out, then another priority-3
+*           receiver blocks. The messages go out as 5, 3, 3, 1, and the two
+*           priority-3 receivers are served in the order they blocked.
+* Phase 3 - A 1-slot MBOX_WAKE_PRIORITY mailbox is full. A wake-priority-1
+*           sender blocks, then a wake-priority-5 sender. The parent
+*           receives three times: the queued message, then the urgent
+*           sender's, then the other.
+* Phase 4 - A bad wake policy and a wake priority out of range return -1.
+*
+* Expected: Delivery order as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char message[32];
+    char suffix[64];
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: urgent receiver behind five others --- */
+    for (int policy = MBOX_WAKE_FIFO; policy <= MBOX_WAKE_PRIORITY; policy++)
+    {
+        console_output(FALSE, "\n%s: Phase 1 - %s mailbox\n", testName, policy == MBOX_WAKE_FIFO ? "FIFO" : "Priority");
+
+        mailboxId = mailbox_create_policy(5, sizeof(message), policy);
+        for (int i = 1; i <= 5; i++)
+        {
+            sprintf(suffix, "Low%d-Wake1", i);
+            SpawnChild(testName, suffix, Receiver);
+        }
+        SpawnChild(testName, "Urgent-Wake5", Receiver);
+        LetChildrenBlock(testName);
+
+        for (int i = 1; i <= 6; i++)
+        {
+            sprintf(message, "Message %d", i);
+            mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+        }
+        WaitForChildren(testName, 6);
+        mailbox_free(mailboxId);
+    }
+
+    /* --- Phase 2: mixed priorities and a timed-out waiter --- */
+    console_output(FALSE, "\n%s: Phase 2 - Mixed priorities\n", testName);
+
+    mailboxId = mailbox_create_policy(0, sizeof(message), MBOX_WAKE_PRIORITY);
+    SpawnChild(testName, "Low-Wake1", Receiver);
+    SpawnChild(testName, "MidA-Wake3", Receiver);
+    SpawnChild(testName, "High-Wake5", Receiver);
+    SpawnChild(testName, "MidTimed-Wake3", Receiver);
+    LetChildrenBlock(testName);
+
+    k_sleep(200);
+    WaitForChildren(testName, 1);
+
+    SpawnChild(testName, "MidB-Wake3", Receiver);
+    LetChildrenBlock(testName);
+
+    for (int i = 1; i <= 4; i++)
+    {
+        sprintf(message, "Message %d", i);
+        result = mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+        if (result != 0)
+            console_output(FALSE, "%s: send returned %d\n", testName, result);
+    }
+    WaitForChildren(testName, 4);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: blocked senders --- */
+    console_output(FALSE, "\n%s: Phase 3 - Blocked senders\n", testName);
+
+    mailboxId = mailbox_create_policy(1, sizeof(message), MBOX_WAKE_PRIORITY);
+    mailbox_send(mailboxId, "Queued", 7, FALSE);
+    SpawnChild(testName, "SendLow-Wake1", Sender);
+    SpawnChild(testName, "SendUrgent-Wake5", Sender);
+    LetChildrenBlock(testName);
+
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+    WaitForChildren(testName, 2);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 4: invalid args --- */
+    console_output(FALSE, "\n%s: Phase 4 - Invalid args\n", testName);
+
+    result = mailbox_create_policy(1, sizeof(message), 7);
+    console_output(FALSE, "%s: mailbox_create_policy with policy 7 returned %d\n", testName, result);
+    result = mailbox_set_wake_priority(HIGHEST_PRIORITY + 1);
+    console_output(FALSE, "%s: mailbox_set_wake_priority(%d) returned %d\n", testName, HIGHEST_PRIORITY + 1, result);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Wake priority from the number after "Wake" in the name. */
+static int WakePriorityFromName(char* strArgs)
+{
+    int priority = LOWEST_PRIORITY;
+    char* pWake = strstr(strArgs, "Wake");
+
+    if (pWake != NULL)
+    {
+        sscanf(pWake + 4, "%d", &priority);
+    }
+    return priority;
+}
+
+/*********************************************************************************
+* Receiver
+*
+* Sets its wake priority and receives one message; "Timed" in the name makes
+* it give up after 100 ms.
+*********************************************************************************/
+int Receiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    mailbox_set_wake_priority(WakePriorityFromName(strArgs));
+    if (strstr(strArgs, "Timed") != NULL)
+        result = mailbox_receive_timed(mailboxId, message, sizeof(message), 100);
+    else
+        result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", strArgs, result, result >= 0 ? message : "");
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* Sender
+*
+* Sets its wake priority and sends its name to the full mailbox.
+*********************************************************************************/
+int Sender(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    mailbox_set_wake_priority(WakePriorityFromName(strArgs));
+    strncpy(message, strstr(strArgs, "Send"), sizeof(message) - 1);
+    message[sizeof(message) - 1] = '\0';
+    *strrchr(message, '-') = '\0';
+    result = mailbox_send(mailboxId, message, (int)strlen(message) + 1, TRUE);
+    console_output(FALSE, "%s: send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int LaneSender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+/*********************************************************************************
+*
+* MessagingTest48 - Message Priority Lanes
+*
+* Phase 1 - Eight messages go into one mailbox with lanes 0, 2, 0, 3, 1, 2, 3
+*           and 0. They are received highest lane first, and in send order
+*           within a lane.
+* Phase 2 - A 2-slot mailbox is full of lane 0 messages. Child1 (priority 4)
+*           blocks sending on lane 3. One receive admits Child1's message,
+*           and it is received before the remaining lane 0 message.
+* Phase 3 - A priority out of range returns -1. A ring mailbox accepts lane 0
+*           and rejects lane 1 with -1.
+* Phase 4 - A buffer too small for the head message returns -1 and the
+*           message stays queued for the next receive.
+*
+* Expected: Delivery order and return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    char message[32];
+    int lanes[] = { 0, 2, 0, 3, 1, 2, 3, 0 };
+    int kidpid, status;
+    int result;
+    int ringId;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: highest lane first, FIFO within a lane --- */
+    console_output(FALSE, "\n%s: Phase 1 - Lane order\n", testName);
+
+    mailboxId = mailbox_create(10, sizeof(message));
+    for (int i = 0; i < 8; i++)
+    {
+        sprintf(message, "Lane%d-Msg%d", lanes[i], i + 1);
+        mailbox_send_prio(mailboxId, message, (int)strlen(message) + 1, lanes[i], FALSE);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+    mailbox_free(mailboxId);
+
+    /* --- Phase 2: a blocked sender keeps its lane --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocked sender\n", testName);
+
+    mailboxId = mailbox_create(2, sizeof(message));
+    mailbox_send(mailboxId, "Bulk1", 6, FALSE);
+    mailbox_send(mailboxId, "Bulk2", 6, FALSE);
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child1", testName);
+    kidpid = k_spawn(nameBuffer, LaneSender, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+
+    /* Wait on a lower priority child so Child1 runs first and blocks */
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child2", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+
+    for (int i = 0; i < 3; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+    kidpid = k_wait(&status);
+    console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: invalid lanes --- */
+    console_output(FALSE, "\n%s: Phase 3 - Invalid lanes\n", testName);
+
+    mailboxId = mailbox_create(2, sizeof(message));
+    result = mailbox_send_prio(mailboxId, "Bad", 4, -1, FALSE);
+    console_output(FALSE, "%s: mailbox_send_prio with priority -1 returned %d\n", testName, result);
+    result = mailbox_send_prio(mailboxId, "Bad", 4, MESSAGE_LANES, FALSE);
+    console_output(FALSE, "%s: mailbox_send_prio with priority %d returned %d\n", testName, MESSAGE_LANES, result);
+    mailbox_free(mailboxId);
+
+    ringId = mailbox_create_ring(2, sizeof(message));
+    result = mailbox_send_prio(ringId, "Ring", 5, 0, FALSE);
+    console_output(FALSE, "%s: ring mailbox_send_prio on lane 0 returned %d\n", testName, result);
+    result = mailbox_send_prio(ringId, "Ring", 5, 1, FALSE);
+    console_output(FALSE, "%s: ring mailbox_send_prio on lane 1 returned %d\n", testName, result);
+    mailbox_free(ringId);
+
+    /* --- Phase 4: short buffer leaves the head queued --- */
+    console_output(FALSE, "\n%s: Phase 4 - Short buffer\n", testName);
+
+    mailboxId = mailbox_create(2, sizeof(message));
+    mailbox_send(mailboxId, "Low", 4, FALSE);
+    mailbox_send_prio(mailboxId, "Urgent message", 15, 2, FALSE);
+    result = mailbox_receive(mailboxId, message, 4, FALSE);
+    console_output(FALSE, "%s: receive into 4 bytes returned %d\n", testName, result);
+    for (int i = 0; i < 2; i++)
+    {
+        result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: receive returned %d, message '%s'\n", testName, result, message);
+    }
+    mailbox_free(mailboxId);
+
+    k_exit(0);
+    return 0;
+}
+
+/*********************************************************************************
+* LaneSender
+*
+* Blocks sending an urgent message on lane 3 to the full mailbox.
+*********************************************************************************/
+int LaneSender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send_prio(mailboxId, "Urgent", 7, 3, TRUE);
+    console_output(FALSE, "%s: mailbox_send_prio returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
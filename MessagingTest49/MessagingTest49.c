@@ -0,0 +1,297 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int Receiver(char* strArgs);
+int Sender(char* strArgs);
+
+int mailboxId;
+int subIds[3];
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void ShowUsage(char* testName, int mboxId);
+
+/*********************************************************************************
+*
+* MessagingTest49 - Multicast Mailboxes
+*
+* Phase 1 - Three subscriptions to one multicast mailbox. Three sends hold
+*           three message slots plus the spare, not nine. Each subscription
+*           receives all three in order, and then only the spare is left.
+* Phase 2 - A send with no subscriptions is dropped. A subscription receives
+*           only what is sent after it subscribed.
+* Phase 3 - In a 2-slot multicast mailbox the Slow subscription holds both
+*           messages, so a third send returns -2 and Child1 blocks sending.
+*           Slow receiving one admits Child1. Freeing Slow lets go of what
+*           only it still held.
+* Phase 4 - Three children (priority 4) block on their own subscription. One
+*           send wakes all three with the message.
+* Phase 5 - Child1 blocks on a subscription and the multicast mailbox is
+*           freed: its receive returns -1 without a signal. Receiving from
+*           the subscription then returns -1 and freeing it returns 0.
+* Phase 6 - Invalid uses return -1.
+*
+* Expected: Delivery order, slot counts and return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char message[32];
+    void* pSlot;
+    int result;
+    int plainId, fastId, slowId;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: one slot per message, whatever the subscriber count --- */
+    console_output(FALSE, "\n%s: Phase 1 - Shared messages\n", testName);
+
+    mailboxId = mailbox_create_multicast(5, sizeof(message));
+    for (int i = 0; i < 3; i++)
+    {
+        subIds[i] = mailbox_subscribe(mailboxId);
+    }
+    for (int i = 1; i <= 3; i++)
+    {
+        sprintf(message, "Message %d", i);
+        mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+    }
+    ShowUsage(testName, mailboxId);
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result = mailbox_receive(subIds[i], message, sizeof(message), FALSE);
+            console_output(FALSE, "%s: subscription %d receive returned %d, message '%s'\n", testName, i + 1, result, message);
+        }
+    }
+    ShowUsage(testName, mailboxId);
+    mailbox_free(mailboxId);
+    for (int i = 0; i < 3; i++)
+    {
+        mailbox_free(subIds[i]);
+    }
+
+    /* --- Phase 2: what a subscription sees --- */
+    console_output(FALSE, "\n%s: Phase 2 - Late subscription\n", testName);
+
+    mailboxId = mailbox_create_multicast(5, sizeof(message));
+    result = mailbox_send(mailboxId, "Nobody", 7, FALSE);
+    console_output(FALSE, "%s: send with no subscriptions returned %d\n", testName, result);
+    ShowUsage(testName, mailboxId);
+
+    subIds[0] = mailbox_subscribe(mailboxId);
+    mailbox_send(mailboxId, "First", 6, FALSE);
+    subIds[1] = mailbox_subscribe(mailboxId);
+    mailbox_send(mailboxId, "Second", 7, FALSE);
+
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result = mailbox_receive(subIds[i], message, sizeof(message), FALSE);
+            console_output(FALSE, "%s: subscription %d receive returned %d, message '%s'\n", testName, i + 1, result, result >= 0 ? message : "");
+        }
+    }
+    mailbox_free(subIds[0]);
+    mailbox_free(subIds[1]);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: a slow subscription holds messages back --- */
+    console_output(FALSE, "\n%s: Phase 3 - Slow subscription\n", testName);
+
+    mailboxId = mailbox_create_multicast(2, sizeof(message));
+    fastId = mailbox_subscribe(mailboxId);
+    slowId = mailbox_subscribe(mailboxId);
+    mailbox_send(mailboxId, "One", 4, FALSE);
+    mailbox_send(mailboxId, "Two", 4, FALSE);
+    for (int i = 0; i < 2; i++)
+    {
+        result = mailbox_receive(fastId, message, sizeof(message), FALSE);
+        console_output(FALSE, "%s: Fast receive returned %d, message '%s'\n", testName, result, message);
+    }
+    result = mailbox_send(mailboxId, "Three", 6, FALSE);
+    console_output(FALSE, "%s: non-blocking send returned %d\n", testName, result);
+
+    SpawnChild(testName, "Child1", Sender);
+    LetChildrenBlock(testName);
+
+    result = mailbox_receive(slowId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: Slow receive returned %d, message '%s'\n", testName, result, message);
+    WaitForChildren(testName, 1);
+    ShowUsage(testName, mailboxId);
+
+    result = mailbox_free(slowId);
+    console_output(FALSE, "%s: freeing Slow returned %d\n", testName, result);
+    ShowUsage(testName, mailboxId);
+    result = mailbox_receive(fastId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: Fast receive returned %d, message '%s'\n", testName, result, message);
+    ShowUsage(testName, mailboxId);
+    mailbox_free(fastId);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 4: one send wakes every blocked subscription --- */
+    console_output(FALSE, "\n%s: Phase 4 - Blocked receivers\n", testName);
+
+    mailboxId = mailbox_create_multicast(5, sizeof(message));
+    for (int i = 0; i < 3; i++)
+    {
+        subIds[i] = mailbox_subscribe(mailboxId);
+        sprintf(message, "Child%d", i + 1);
+        SpawnChild(testName, message, Receiver);
+    }
+    LetChildrenBlock(testName);
+
+    result = mailbox_send(mailboxId, "Hello all", 10, FALSE);
+    console_output(FALSE, "%s: send returned %d\n", testName, result);
+    WaitForChildren(testName, 3);
+    ShowUsage(testName, mailboxId);
+    for (int i = 0; i < 3; i++)
+    {
+        mailbox_free(subIds[i]);
+    }
+    mailbox_free(mailboxId);
+
+    /* --- Phase 5: freeing the multicast mailbox --- */
+    console_output(FALSE, "\n%s: Phase 5 - Multicast mailbox freed\n", testName);
+
+    mailboxId = mailbox_create_multicast(5, sizeof(message));
+    subIds[0] = mailbox_subscribe(mailboxId);
+    SpawnChild(testName, "Child1", Receiver);
+    LetChildrenBlock(testName);
+
+    result = mailbox_free(mailboxId);
+    console_output(FALSE, "%s: mailbox_free returned %d\n", testName, result);
+    WaitForChildren(testName, 1);
+
+    result = mailbox_receive(subIds[0], message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive from the subscription returned %d\n", testName, result);
+    result = mailbox_free(subIds[0]);
+    console_output(FALSE, "%s: freeing the subscription returned %d\n", testName, result);
+
+    /* --- Phase 6: invalid uses --- */
+    console_output(FALSE, "\n%s: Phase 6 - Invalid uses\n", testName);
+
+    mailboxId = mailbox_create_multicast(5, sizeof(message));
+    subIds[0] = mailbox_subscribe(mailboxId);
+    plainId = mailbox_create(5, sizeof(message));
+
+    result = mailbox_create_multicast(0, sizeof(message));
+    console_output(FALSE, "%s: mailbox_create_multicast with 0 slots returned %d\n", testName, result);
+    result = mailbox_subscribe(plainId);
+    console_output(FALSE, "%s: mailbox_subscribe to a plain mailbox returned %d\n", testName, result);
+    result = mailbox_subscribe(subIds[0]);
+    console_output(FALSE, "%s: mailbox_subscribe to a subscription returned %d\n", testName, result);
+    result = mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: receive from the multicast mailbox returned %d\n", testName, result);
+    result = mailbox_send(subIds[0], "Bad", 4, FALSE);
+    console_output(FALSE, "%s: send to a subscription returned %d\n", testName, result);
+    result = mailbox_send_prio(mailboxId, "Bad", 4, 1, FALSE);
+    console_output(FALSE, "%s: mailbox_send_prio on lane 1 returned %d\n", testName, result);
+    result = mailbox_send_reserve(mailboxId, 4, &pSlot, FALSE);
+    console_output(FALSE, "%s: mailbox_send_reserve returned %d\n", testName, result);
+    result = mailbox_receive_acquire(subIds[0], &pSlot, FALSE);
+    console_output(FALSE, "%s: mailbox_receive_acquire from a subscription returned %d\n", testName, result);
+
+    mailbox_free(subIds[0]);
+    mailbox_free(mailboxId);
+    mailbox_free(plainId);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Messages held and pool slots in use, the spare slot included. */
+void ShowUsage(char* testName, int mboxId)
+{
+    mailbox_usage_t usage;
+
+    mailbox_get_usage(mboxId, &usage);
+    console_output(FALSE, "%s: %d messages held in %d slots\n", testName, usage.queued, usage.slotsInUse);
+}
+
+/*********************************************************************************
+* Receiver
+*
+* Blocks on subscription subIds[child number - 1].
+*********************************************************************************/
+int Receiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive(subIds[GetChildNumber(strArgs) - 1], message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", strArgs, result, result >= 0 ? message : "");
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* Sender
+*
+* Blocks sending to the full multicast mailbox.
+*********************************************************************************/
+int Sender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send(mailboxId, "Three", 6, TRUE);
+    console_output(FALSE, "%s: send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int TerminalWaiter(char* strArgs);
+
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void WriteChar(char* deviceName, char c);
+
+/*********************************************************************************
+*
+* MessagingTest50 - Device Events Without the Slot Pool
+*
+* Phase 1 - The shared slot pool is filled until a send returns -2. A write
+*           to term0 still completes: wait_device returns 0 with the status,
+*           since device events do not use mail slots.
+* Phase 2 - Child1 and Child2 (priority 4) block in wait_device on term1.
+*           Each write to term1 wakes one of them, Child1 first.
+* Phase 3 - A write to term2 completes while the test sleeps and nobody is
+*           waiting. The event is kept, and the next wait_device on term2
+*           returns it at once.
+*
+* Expected: Every wait_device returns 0 with a write-complete status.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char message[MAX_MESSAGE];
+    int mailboxId;
+    int status = 0;
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+    memset(message, 'x', sizeof(message));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: no free slots --- */
+    console_output(FALSE, "\n%s: Phase 1 - Slot pool exhausted\n", testName);
+
+    mailboxId = mailbox_create(MAXSLOTS, MAX_MESSAGE);
+    do
+    {
+        result = mailbox_send(mailboxId, message, sizeof(message), FALSE);
+    } while (result == 0);
+    console_output(FALSE, "%s: send to fill the pool stopped with %d\n", testName, result);
+
+    WriteChar("term0", 'A');
+    result = wait_device("term0", &status);
+    console_output(FALSE, "%s: wait_device on term0 returned %d with status 0x%08x\n", testName, result, status);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 2: waiters are woken in order --- */
+    console_output(FALSE, "\n%s: Phase 2 - Two waiters\n", testName);
+
+    SpawnChild(testName, "Child1", TerminalWaiter);
+    SpawnChild(testName, "Child2", TerminalWaiter);
+    LetChildrenBlock(testName);
+
+    WriteChar("term1", 'B');
+    WaitForChildren(testName, 1);
+    WriteChar("term1", 'C');
+    WaitForChildren(testName, 1);
+
+    /* --- Phase 3: an event that arrives before the wait --- */
+    console_output(FALSE, "\n%s: Phase 3 - Event before the wait\n", testName);
+
+    WriteChar("term2", 'D');
+    k_sleep(100);
+    result = wait_device("term2", &status);
+    console_output(FALSE, "%s: wait_device on term2 returned %d with status 0x%08x\n", testName, result, status);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Start writing one character to a terminal. */
+void WriteChar(char* deviceName, char c)
+{
+    device_control_block_t controlBlock;
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)c;
+    device_control(deviceName, controlBlock);
+}
+
+/*********************************************************************************
+* TerminalWaiter
+*
+* Blocks in wait_device on term1.
+*********************************************************************************/
+int TerminalWaiter(char* strArgs)
+{
+    int status = 0;
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = wait_device("term1", &status);
+    console_output(FALSE, "%s: wait_device returned %d with status 0x%08x\n", strArgs, result, status);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define BURST   20
+
+void WriteBurst(char* deviceName, int count);
+void ShowStats(char* testName, char* deviceName);
+
+/*********************************************************************************
+*
+* MessagingTest51 - Device Event Overflow
+*
+* Phase 1 - BURST writes to term3 complete while nobody is waiting, more than
+*           the device event ring holds. The first 15 wait_device calls each
+*           return 0 with one write status, in order. The next returns the
+*           number of events coalesced, with the status of the last write.
+* Phase 2 - The same burst with DEVICE_OVERFLOW_DROP: 15 events are taken
+*           and the rest are counted as dropped.
+* Phase 3 - Invalid uses return -1.
+*
+* Expected: Statuses, counts and return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    device_stats_t stats;
+    int status = 0;
+    int result;
+    int taken;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: coalesced overflow --- */
+    console_output(FALSE, "\n%s: Phase 1 - Coalesced overflow\n", testName);
+
+    WriteBurst("term3", BURST);
+    k_sleep(200);
+    ShowStats(testName, "term3");
+
+    taken = 0;
+    while (taken < BURST)
+    {
+        result = wait_device("term3", &status);
+        console_output(FALSE, "%s: wait_device returned %d with status 0x%08x\n", testName, result, status);
+        taken += result > 0 ? result : 1;
+    }
+    ShowStats(testName, "term3");
+
+    /* --- Phase 2: dropped overflow --- */
+    console_output(FALSE, "\n%s: Phase 2 - Dropped overflow\n", testName);
+
+    result = wait_device_set_overflow("term3", DEVICE_OVERFLOW_DROP);
+    console_output(FALSE, "%s: wait_device_set_overflow returned %d\n", testName, result);
+    WriteBurst("term3", BURST);
+    k_sleep(200);
+    ShowStats(testName, "term3");
+
+    for (int i = 0; i < 15; i++)
+    {
+        wait_device("term3", &status);
+    }
+    console_output(FALSE, "%s: last status taken 0x%08x\n", testName, status);
+    ShowStats(testName, "term3");
+    wait_device_set_overflow("term3", DEVICE_OVERFLOW_COALESCE);
+
+    /* --- Phase 3: invalid uses --- */
+    console_output(FALSE, "\n%s: Phase 3 - Invalid uses\n", testName);
+
+    result = wait_device_set_overflow("term3", 7);
+    console_output(FALSE, "%s: wait_device_set_overflow with mode 7 returned %d\n", testName, result);
+    result = wait_device_set_overflow("clock", DEVICE_OVERFLOW_DROP);
+    console_output(FALSE, "%s: wait_device_set_overflow on the clock returned %d\n", testName, result);
+    result = wait_device_get_stats("term9", &stats);
+    console_output(FALSE, "%s: wait_device_get_stats on term9 returned %d\n", testName, result);
+    result = wait_device_get_stats("term3", NULL);
+    console_output(FALSE, "%s: wait_device_get_stats with no stats returned %d\n", testName, result);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Start count single-character writes to a terminal, 'a' first. */
+void WriteBurst(char* deviceName, int count)
+{
+    device_control_block_t controlBlock;
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    for (int i = 0; i < count; i++)
+    {
+        controlBlock.output_data = (void*)(uintptr_t)('a' + i);
+        device_control(deviceName, controlBlock);
+    }
+}
+
+void ShowStats(char* testName, char* deviceName)
+{
+    device_stats_t stats;
+
+    wait_device_get_stats(deviceName, &stats);
+    console_output(FALSE, "%s: %s events %d, dropped %d, coalesced %d, pending %d\n", testName, deviceName,
+        stats.events, stats.dropped, stats.coalesced, stats.pending);
+}
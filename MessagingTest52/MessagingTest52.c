@@ -0,0 +1,70 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+/*********************************************************************************
+*
+* MessagingTest52 - Device Handles
+*
+* Phase 1 - wait_device_open returns a handle for term0 and for the clock,
+*           and -1 for a device that does not exist.
+* Phase 2 - Three writes to term0, each waited for with wait_device_h on the
+*           term0 handle, return 0 with each write's status. wait_device_h on
+*           the clock handle returns 1 on the first wait.
+* Phase 3 - Handles out of range and a NULL status return -1.
+*
+* Expected: Return codes and statuses as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    device_control_block_t controlBlock;
+    int termHandle, clockHandle;
+    int status = 0;
+    int result;
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: opening devices --- */
+    console_output(FALSE, "\n%s: Phase 1 - Open\n", testName);
+
+    termHandle = wait_device_open("term0");
+    console_output(FALSE, "%s: wait_device_open on term0 %s\n", testName, termHandle >= 0 ? "returned a handle" : "failed");
+    clockHandle = wait_device_open("clock");
+    console_output(FALSE, "%s: wait_device_open on the clock %s\n", testName, clockHandle >= 0 ? "returned a handle" : "failed");
+    result = wait_device_open("term9");
+    console_output(FALSE, "%s: wait_device_open on term9 returned %d\n", testName, result);
+
+    /* --- Phase 2: waiting on handles --- */
+    console_output(FALSE, "\n%s: Phase 2 - Wait\n", testName);
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    for (int i = 0; i < 3; i++)
+    {
+        controlBlock.output_data = (void*)(uintptr_t)('X' + i);
+        device_control("term0", controlBlock);
+        result = wait_device_h(termHandle, &status);
+        console_output(FALSE, "%s: wait_device_h on term0 returned %d with status 0x%08x\n", testName, result, status);
+    }
+    result = wait_device_h(clockHandle, &status);
+    console_output(FALSE, "%s: wait_device_h on the clock returned %d\n", testName, result);
+
+    /* --- Phase 3: invalid handles --- */
+    console_output(FALSE, "\n%s: Phase 3 - Invalid uses\n", testName);
+
+    result = wait_device_h(-1, &status);
+    console_output(FALSE, "%s: wait_device_h with handle -1 returned %d\n", testName, result);
+    result = wait_device_h(THREADS_MAX_DEVICES, &status);
+    console_output(FALSE, "%s: wait_device_h with handle %d returned %d\n", testName, THREADS_MAX_DEVICES, result);
+    result = wait_device_h(termHandle, NULL);
+    console_output(FALSE, "%s: wait_device_h with no status returned %d\n", testName, result);
+
+    k_exit(0);
+    return 0;
+}
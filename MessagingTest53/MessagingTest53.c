@@ -0,0 +1,213 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int UserMessaging(char* strArgs);
+int UserReceiver(char* strArgs);
+int UserDeviceWaiter(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void EnterUserMode(char* name);
+void LeaveUserMode(void);
+
+/*********************************************************************************
+*
+* MessagingTest53 - User-Mode System Calls
+*
+* Each child (priority 4) drops to user mode and uses only the sys_ stubs.
+*
+* Phase 1 - Child1 creates a mailbox, sends two messages, receives them in
+*           order and frees the mailbox.
+* Phase 2 - Child2 blocks in sys_mailbox_receive on a mailbox the test
+*           created. The test sends from kernel mode and Child2 receives it.
+* Phase 3 - Child3 blocks in sys_wait_device on term1. The test writes to
+*           term1 and Child3 gets the write status.
+*
+* Expected: Every call returns as its kernel-mode counterpart would.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    device_control_block_t controlBlock;
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: the whole mailbox API from user mode --- */
+    console_output(FALSE, "\n%s: Phase 1 - Create, send, receive, free\n", testName);
+
+    SpawnChild(testName, "Child1", UserMessaging);
+    WaitForChildren(testName, 1);
+
+    /* --- Phase 2: a user process blocked in a system call --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocked receive\n", testName);
+
+    mailboxId = mailbox_create(5, 32);
+    SpawnChild(testName, "Child2", UserReceiver);
+    LetChildrenBlock(testName);
+
+    result = mailbox_send(mailboxId, "From the kernel", 16, FALSE);
+    console_output(FALSE, "%s: mailbox_send returned %d\n", testName, result);
+    WaitForChildren(testName, 1);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 3: waiting on a device from user mode --- */
+    console_output(FALSE, "\n%s: Phase 3 - Device wait\n", testName);
+
+    SpawnChild(testName, "Child3", UserDeviceWaiter);
+    LetChildrenBlock(testName);
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)'U';
+    device_control("term1", controlBlock);
+    WaitForChildren(testName, 1);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Clear the kernel mode bit of the PSR. */
+void EnterUserMode(char* name)
+{
+    set_psr(get_psr() & ~PSR_KERNEL_MODE);
+    console_output(FALSE, "%s: running in %s mode\n", name, (get_psr() & PSR_KERNEL_MODE) ? "kernel" : "user");
+}
+
+/* There is no exit system call, so children go back to kernel mode to k_exit. */
+void LeaveUserMode(void)
+{
+    set_psr(get_psr() | PSR_KERNEL_MODE);
+}
+
+/*********************************************************************************
+* UserMessaging
+*
+* Creates, uses and frees a mailbox through the system call stubs.
+*********************************************************************************/
+int UserMessaging(char* strArgs)
+{
+    char message[32];
+    int mboxId, result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    EnterUserMode(strArgs);
+
+    mboxId = sys_mailbox_create(5, sizeof(message));
+    console_output(FALSE, "%s: sys_mailbox_create %s\n", strArgs, mboxId >= 0 ? "returned a mailbox id" : "failed");
+    for (int i = 1; i <= 2; i++)
+    {
+        sprintf(message, "User message %d", i);
+        result = sys_mailbox_send(mboxId, message, (int)strlen(message) + 1, TRUE);
+        console_output(FALSE, "%s: sys_mailbox_send returned %d\n", strArgs, result);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        result = sys_mailbox_receive(mboxId, message, sizeof(message), TRUE);
+        console_output(FALSE, "%s: sys_mailbox_receive returned %d, message '%s'\n", strArgs, result, message);
+    }
+    result = sys_mailbox_receive(mboxId, message, sizeof(message), FALSE);
+    console_output(FALSE, "%s: non-blocking sys_mailbox_receive on the empty mailbox returned %d\n", strArgs, result);
+    result = sys_mailbox_free(mboxId);
+    console_output(FALSE, "%s: sys_mailbox_free returned %d\n", strArgs, result);
+    result = sys_mailbox_send(mboxId, "Late", 5, FALSE);
+    console_output(FALSE, "%s: sys_mailbox_send to the freed mailbox returned %d\n", strArgs, result);
+
+    LeaveUserMode();
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* UserReceiver
+*
+* Blocks in sys_mailbox_receive on mailboxId.
+*********************************************************************************/
+int UserReceiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    EnterUserMode(strArgs);
+
+    result = sys_mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: sys_mailbox_receive returned %d, message '%s'\n", strArgs, result, message);
+
+    LeaveUserMode();
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* UserDeviceWaiter
+*
+* Blocks in sys_wait_device on term1.
+*********************************************************************************/
+int UserDeviceWaiter(char* strArgs)
+{
+    int status = 0;
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    EnterUserMode(strArgs);
+
+    result = sys_wait_device("term1", &status);
+    console_output(FALSE, "%s: sys_wait_device returned %d with status 0x%08x\n", strArgs, result, status);
+
+    LeaveUserMode();
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,217 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+int Receiver(char* strArgs);
+int Sender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void ShowStats(char* testName, int mboxId);
+
+/*********************************************************************************
+*
+* MessagingTest54 - Mailbox Statistics
+*
+* Phase 1 - A 3-slot mailbox gets three 10-byte sends, a fourth non-blocking
+*           send that returns -2, and two receives. The counters show 3
+*           sends, 2 receives, 1 would-block, depth 1 and peak depth 3.
+* Phase 2 - Child1 (priority 4) blocks receiving from an empty mailbox and
+*           Child2 blocks sending to it once it is full. Each is counted
+*           once as blocked, and its message once as sent or received.
+* Phase 3 - A batch send of four, a batch receive of four, and a reserve,
+*           commit and acquire each count per message.
+* Phase 4 - display_mailbox_table lists the mailboxes in use, the device
+*           mailboxes included.
+* Phase 5 - A freed mailbox and a NULL stats pointer return -1.
+*
+* Expected: Counters and return codes as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char message[32];
+    char buffers[4][32];
+    void* pMsgs[4];
+    int sizes[4];
+    void* pSlot;
+    mailbox_stats_t stats;
+    int result;
+    int batchId;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: sends, receives and a full mailbox --- */
+    console_output(FALSE, "\n%s: Phase 1 - Counting\n", testName);
+
+    mailboxId = mailbox_create(3, sizeof(message));
+    for (int i = 1; i <= 3; i++)
+    {
+        sprintf(message, "Message %d", i);
+        mailbox_send(mailboxId, message, (int)strlen(message) + 1, FALSE);
+    }
+    result = mailbox_send(mailboxId, "Message 4", 10, FALSE);
+    console_output(FALSE, "%s: send to the full mailbox returned %d\n", testName, result);
+    for (int i = 0; i < 2; i++)
+    {
+        mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    }
+    ShowStats(testName, mailboxId);
+    mailbox_free(mailboxId);
+
+    /* --- Phase 2: blocked senders and receivers --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocking\n", testName);
+
+    mailboxId = mailbox_create(1, sizeof(message));
+    SpawnChild(testName, "Child1", Receiver);
+    LetChildrenBlock(testName);
+    mailbox_send(mailboxId, "For Child1", 11, FALSE);
+    WaitForChildren(testName, 1);
+
+    mailbox_send(mailboxId, "Filler", 7, FALSE);
+    SpawnChild(testName, "Child2", Sender);
+    LetChildrenBlock(testName);
+    mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    WaitForChildren(testName, 1);
+    ShowStats(testName, mailboxId);
+
+    /* --- Phase 3: batches and zero-copy --- */
+    console_output(FALSE, "\n%s: Phase 3 - Batch and zero-copy\n", testName);
+
+    batchId = mailbox_create(5, sizeof(message));
+    for (int i = 0; i < 4; i++)
+    {
+        sprintf(buffers[i], "Batch %d", i + 1);
+        pMsgs[i] = buffers[i];
+        sizes[i] = (int)strlen(buffers[i]) + 1;
+    }
+    result = mailbox_send_batch(batchId, pMsgs, sizes, 4, FALSE);
+    console_output(FALSE, "%s: mailbox_send_batch returned %d\n", testName, result);
+    result = mailbox_receive_batch(batchId, pMsgs, sizeof(buffers[0]), sizes, 4, FALSE);
+    console_output(FALSE, "%s: mailbox_receive_batch returned %d\n", testName, result);
+
+    mailbox_send_reserve(batchId, 6, &pSlot, FALSE);
+    strcpy((char*)pSlot, "Inner");
+    mailbox_send_commit(batchId, pSlot);
+    result = mailbox_receive_acquire(batchId, &pSlot, FALSE);
+    console_output(FALSE, "%s: mailbox_receive_acquire returned %d, message '%s'\n", testName, result, (char*)pSlot);
+    mailbox_receive_release(batchId, pSlot);
+    ShowStats(testName, batchId);
+
+    /* --- Phase 4: the table --- */
+    console_output(FALSE, "\n%s: Phase 4 - Mailbox table\n", testName);
+
+    display_mailbox_table();
+    mailbox_free(mailboxId);
+    mailbox_free(batchId);
+
+    /* --- Phase 5: invalid uses --- */
+    console_output(FALSE, "\n%s: Phase 5 - Invalid uses\n", testName);
+
+    result = mailbox_get_stats(mailboxId, &stats);
+    console_output(FALSE, "%s: mailbox_get_stats on a freed mailbox returned %d\n", testName, result);
+    batchId = mailbox_create(1, sizeof(message));
+    result = mailbox_get_stats(batchId, NULL);
+    console_output(FALSE, "%s: mailbox_get_stats with no stats returned %d\n", testName, result);
+    mailbox_free(batchId);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+void ShowStats(char* testName, int mboxId)
+{
+    mailbox_stats_t stats;
+
+    mailbox_get_stats(mboxId, &stats);
+    console_output(FALSE, "%s: sends %d, receives %d, blocked sends %d, blocked receives %d, would block %d\n",
+        testName, stats.sends, stats.receives, stats.blockedSends, stats.blockedReceives, stats.wouldBlock);
+    console_output(FALSE, "%s: depth %d, peak depth %d, bytes sent %lld, bytes received %lld\n",
+        testName, stats.depth, stats.peakDepth, stats.bytesSent, stats.bytesReceived);
+}
+
+/*********************************************************************************
+* Receiver
+*
+* Blocks receiving from the empty mailbox.
+*********************************************************************************/
+int Receiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", strArgs, result, message);
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* Sender
+*
+* Blocks sending to the full mailbox.
+*********************************************************************************/
+int Sender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send(mailboxId, "From Child2", 12, TRUE);
+    console_output(FALSE, "%s: send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
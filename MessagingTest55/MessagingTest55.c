@@ -0,0 +1,204 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define TRACE_FILE  "MessagingTest55.trace"
+
+int Receiver(char* strArgs);
+
+int firstMailboxId;
+int mailboxId;
+int parentPid;
+int childPid;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void ShowTrace(char* testName, char* fileName);
+
+/*********************************************************************************
+*
+* MessagingTest55 - Event Trace
+*
+* Phase 1 - After mailbox_trace_reset the test sends two messages to a new
+*           mailbox and receives one. Child1 (priority 4) then blocks
+*           receiving from a second, empty mailbox and is woken by a send.
+*           Both mailboxes are freed, the first with one message still
+*           queued. A write to term0 is waited for.
+* Phase 2 - mailbox_trace_dump writes the trace. The file is read back: the
+*           header, then each record on the test's mailboxes or from a
+*           device, in order. Timestamps are checked to be in order, and
+*           the header's trace clock and read_clock() pairs to run forward,
+*           but not printed, since they depend on the host.
+* Phase 3 - A NULL file name and a file that cannot be created return -1.
+*
+* Expected: The records listed above, in the order the events happened.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    device_control_block_t controlBlock;
+    char message[32];
+    int status;
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+    parentPid = k_getpid();
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: traced operations --- */
+    console_output(FALSE, "\n%s: Phase 1 - Mailbox and device operations\n", testName);
+
+    mailbox_trace_reset();
+
+    firstMailboxId = mailbox_create(5, sizeof(message));
+    mailbox_send(firstMailboxId, "First", 6, FALSE);
+    mailbox_send(firstMailboxId, "Second!", 8, FALSE);
+    mailbox_receive(firstMailboxId, message, sizeof(message), FALSE);
+
+    mailboxId = mailbox_create(5, sizeof(message));
+    SpawnChild(testName, "Child1", Receiver);
+    LetChildrenBlock(testName);
+    mailbox_send(mailboxId, "Wake up", 8, FALSE);
+    WaitForChildren(testName, 1);
+
+    mailbox_free(firstMailboxId);
+    mailbox_free(mailboxId);
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)'T';
+    device_control("term0", controlBlock);
+    wait_device("term0", &status);
+
+    /* --- Phase 2: dump and read back --- */
+    console_output(FALSE, "\n%s: Phase 2 - Dump\n", testName);
+
+    result = mailbox_trace_dump(TRACE_FILE);
+    console_output(FALSE, "%s: mailbox_trace_dump %s\n", testName, result > 0 ? "wrote records" : "failed");
+    ShowTrace(testName, TRACE_FILE);
+    remove(TRACE_FILE);
+
+    /* --- Phase 3: invalid uses --- */
+    console_output(FALSE, "\n%s: Phase 3 - Invalid uses\n", testName);
+
+    result = mailbox_trace_dump(NULL);
+    console_output(FALSE, "%s: mailbox_trace_dump with no file name returned %d\n", testName, result);
+    result = mailbox_trace_dump("no-such-directory/MessagingTest55.trace");
+    console_output(FALSE, "%s: mailbox_trace_dump to a missing directory returned %d\n", testName, result);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    childPid = kidpid;
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Read a trace file back and print the records that belong to this test. */
+void ShowTrace(char* testName, char* fileName)
+{
+    static const char* eventNames[] = { "?", "send", "receive", "block", "unblock", "free", "device" };
+    mailbox_trace_header_t header;
+    mailbox_trace_record_t record;
+    uint64_t lastTime = 0;
+    int inOrder = 1;
+    FILE* file;
+
+    file = fopen(fileName, "rb");
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1)
+    {
+        console_output(FALSE, "%s: could not read the trace file\n", testName);
+        if (file)
+            fclose(file);
+        return;
+    }
+    console_output(FALSE, "%s: magic %.4s, version %u, record size %u, overwritten %u\n",
+        testName, header.magic, header.version, header.recordSize, header.overwritten);
+    console_output(FALSE, "%s: trace clock runs forward: %s\n", testName,
+        header.endStamp > header.startStamp && header.endClock >= header.startClock ? "yes" : "no");
+
+    for (uint32_t i = 0; i < header.recordCount && fread(&record, sizeof(record), 1, file) == 1; i++)
+    {
+        char* who = record.pid == parentPid ? "test" : record.pid == childPid ? "Child1" : "other";
+
+        if (record.timestamp < lastTime)
+            inOrder = 0;
+        lastTime = record.timestamp;
+
+        if (record.event == MAILBOX_TRACE_DEVICE)
+        {
+            console_output(FALSE, "%s:   device  status 0x%08x\n", testName, record.size);
+        }
+        else if (record.mboxId == mailboxId || record.mboxId == firstMailboxId)
+        {
+            console_output(FALSE, "%s:   %-7s %-6s mailbox %s size %d\n", testName, eventNames[record.event], who,
+                record.mboxId == mailboxId ? "two" : "one", record.size);
+        }
+    }
+    console_output(FALSE, "%s: timestamps %s\n", testName, inOrder ? "in order" : "out of order");
+
+    fclose(file);
+}
+
+/*********************************************************************************
+* Receiver
+*
+* Blocks receiving from the empty mailbox.
+*********************************************************************************/
+int Receiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", strArgs, result, message);
+
+    k_exit(-3);
+    return 0;
+}
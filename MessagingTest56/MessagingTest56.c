@@ -0,0 +1,203 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define HOLD_MS     100     /* how long the test keeps a child blocked */
+
+int Receiver(char* strArgs);
+int Sender(char* strArgs);
+
+int mailboxId;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*));
+void LetChildrenBlock(char* testName);
+void WaitForChildren(char* testName, int count);
+void CheckLatency(char* testName, mailbox_latency_t* lat, int samples, unsigned int atLeastUs);
+
+/*********************************************************************************
+*
+* MessagingTest56 - Blocking-Time Histograms
+*
+* Phase 1 - A new mailbox has no samples. A non-blocking receive and a
+*           receive that finds a message do not add any.
+* Phase 2 - Child1 (priority 4) blocks receiving and is held for HOLD_MS
+*           before the test sends. Child2 then blocks sending to the full
+*           mailbox and is held for HOLD_MS before the test receives. Each
+*           blocked call adds one sample of at least HOLD_MS.
+* Phase 3 - A wait_device on term0 that blocks adds one sample to the
+*           device's histogram.
+* Phase 4 - Invalid ids, devices and NULL pointers return -1.
+*
+* Times depend on the host, so only their bounds are printed.
+*
+* Expected: Sample counts and bounds as described above.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    device_control_block_t controlBlock;
+    mailbox_latency_t lat;
+    char message[32];
+    int status;
+    int result;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: calls that do not block --- */
+    console_output(FALSE, "\n%s: Phase 1 - No blocking\n", testName);
+
+    mailboxId = mailbox_create(1, sizeof(message));
+    mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    mailbox_send(mailboxId, "Queued", 7, FALSE);
+    mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    mailbox_get_latency(mailboxId, &lat);
+    CheckLatency(testName, &lat, 0, 0);
+
+    /* --- Phase 2: a blocked receiver and a blocked sender --- */
+    console_output(FALSE, "\n%s: Phase 2 - Blocked calls\n", testName);
+
+    SpawnChild(testName, "Child1", Receiver);
+    LetChildrenBlock(testName);
+    k_sleep(HOLD_MS);
+    mailbox_send(mailboxId, "For Child1", 11, FALSE);
+    WaitForChildren(testName, 1);
+    mailbox_get_latency(mailboxId, &lat);
+    CheckLatency(testName, &lat, 1, HOLD_MS * 1000);
+
+    mailbox_send(mailboxId, "Filler", 7, FALSE);
+    SpawnChild(testName, "Child2", Sender);
+    LetChildrenBlock(testName);
+    k_sleep(HOLD_MS);
+    mailbox_receive(mailboxId, message, sizeof(message), FALSE);
+    WaitForChildren(testName, 1);
+    mailbox_get_latency(mailboxId, &lat);
+    CheckLatency(testName, &lat, 2, HOLD_MS * 1000);
+
+    /* --- Phase 3: a device wait --- */
+    console_output(FALSE, "\n%s: Phase 3 - Device wait\n", testName);
+
+    memset(&controlBlock, 0, sizeof(controlBlock));
+    controlBlock.command = TERMINAL_WRITE_CHAR;
+    controlBlock.output_data = (void*)(uintptr_t)'L';
+    device_control("term0", controlBlock);
+    wait_device("term0", &status);
+    wait_device_get_latency("term0", &lat);
+    CheckLatency(testName, &lat, 1, 0);
+
+    /* --- Phase 4: invalid uses --- */
+    console_output(FALSE, "\n%s: Phase 4 - Invalid uses\n", testName);
+
+    result = mailbox_get_latency(mailboxId, NULL);
+    console_output(FALSE, "%s: mailbox_get_latency with no histogram returned %d\n", testName, result);
+    mailbox_free(mailboxId);
+    result = mailbox_get_latency(mailboxId, &lat);
+    console_output(FALSE, "%s: mailbox_get_latency on a freed mailbox returned %d\n", testName, result);
+    result = wait_device_get_latency("term9", &lat);
+    console_output(FALSE, "%s: wait_device_get_latency on term9 returned %d\n", testName, result);
+    result = wait_device_get_latency("term0", NULL);
+    console_output(FALSE, "%s: wait_device_get_latency with no histogram returned %d\n", testName, result);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a priority 4 child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*))
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, 4);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Wait on a lower priority child so the priority 4 children run first and block. */
+void LetChildrenBlock(char* testName)
+{
+    char nameBuffer[512];
+    int kidpid, status;
+    int delayPid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Delay", testName);
+    delayPid = k_spawn(nameBuffer, SimpleDelayExit, NULL, THREADS_MIN_STACK_SIZE, 3);
+    do
+    {
+        kidpid = k_wait(&status);
+        if (kidpid != delayPid)
+            console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    } while (kidpid != delayPid);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/* Print the sample count and whether the summary is consistent with the buckets. */
+void CheckLatency(char* testName, mailbox_latency_t* lat, int samples, unsigned int atLeastUs)
+{
+    int inBuckets = 0;
+
+    for (int b = 0; b < MAILBOX_LATENCY_BUCKETS; b++)
+        inBuckets += lat->buckets[b];
+
+    console_output(FALSE, "%s: samples %d (expected %d), in buckets %d\n", testName, lat->samples, samples, inBuckets);
+    console_output(FALSE, "%s: p50 <= p99 <= max: %s\n", testName,
+        lat->p50 <= lat->p99 && lat->p99 <= lat->max ? "yes" : "no");
+    if (atLeastUs > 0)
+    {
+        console_output(FALSE, "%s: max at least %u ms: %s\n", testName, atLeastUs / 1000,
+            lat->max >= atLeastUs ? "yes" : "no");
+    }
+}
+
+/*********************************************************************************
+* Receiver
+*
+* Blocks receiving from the empty mailbox.
+*********************************************************************************/
+int Receiver(char* strArgs)
+{
+    char message[32];
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_receive(mailboxId, message, sizeof(message), TRUE);
+    console_output(FALSE, "%s: receive returned %d, message '%s'\n", strArgs, result, message);
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* Sender
+*
+* Blocks sending to the full mailbox.
+*********************************************************************************/
+int Sender(char* strArgs)
+{
+    int result;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+    result = mailbox_send(mailboxId, "From Child2", 12, TRUE);
+    console_output(FALSE, "%s: send returned %d\n", strArgs, result);
+
+    k_exit(-3);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include "THREADSLib.h"
+#include "Scheduler.h"
+#include "Messaging.h"
+#include "TestCommon.h"
+
+#define DELAY_MS    100
+
+int Delayer(char* strArgs);
+int Worker(char* strArgs);
+
+int delayerDone;
+char childNames[MAXPROC][256];
+
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*), int priority);
+void WaitForChildren(char* testName, int count);
+
+/*********************************************************************************
+*
+* MessagingTest57 - Delays That Block
+*
+* Phase 1 - Child1 (priority 4) calls SystemDelay(DELAY_MS). Child2
+*           (priority 2) can only run if Child1 gives up the CPU, so it runs
+*           while Child1 waits. Child1 is delayed at least DELAY_MS and uses
+*           almost none of it as CPU time.
+* Phase 2 - The same with the shared SimpleDelayExit child (priority 3),
+*           which delays 10 ms, and Child4 (priority 1). Child4 exits
+*           before Child3 is done.
+*
+* CPU times depend on the host, so only their bounds are printed.
+*
+* Expected: The lower priority child runs during each delay.
+*
+*********************************************************************************/
+int MessagingEntryPoint(void* pArgs)
+{
+    char* testName = GetTestName(__FILE__);
+    char nameBuffer[512];
+    int kidpid;
+
+    memset(childNames, 0, sizeof(childNames));
+
+    console_output(FALSE, "\n%s: started\n", testName);
+
+    /* --- Phase 1: SystemDelay --- */
+    console_output(FALSE, "\n%s: Phase 1 - SystemDelay\n", testName);
+
+    delayerDone = 0;
+    SpawnChild(testName, "Child1", Delayer, 4);
+    SpawnChild(testName, "Child2", Worker, 2);
+    WaitForChildren(testName, 2);
+
+    /* --- Phase 2: SimpleDelayExit --- */
+    console_output(FALSE, "\n%s: Phase 2 - SimpleDelayExit\n", testName);
+
+    delayerDone = 0;
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-Child3", testName);
+    kidpid = k_spawn(nameBuffer, SimpleDelayExit, nameBuffer, THREADS_MIN_STACK_SIZE, 3);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+    SpawnChild(testName, "Child4", Worker, 1);
+    WaitForChildren(testName, 2);
+
+    k_exit(0);
+    return 0;
+}
+
+/* Spawn a child named <test>-<suffix>. */
+void SpawnChild(char* testName, char* suffix, int (*entry)(char*), int priority)
+{
+    char nameBuffer[512];
+    int kidpid;
+
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s-%s", testName, suffix);
+    kidpid = k_spawn(nameBuffer, entry, nameBuffer, THREADS_MIN_STACK_SIZE, priority);
+    strncpy(childNames[kidpid], nameBuffer, 256);
+}
+
+/* Collect count children, reporting each exit. */
+void WaitForChildren(char* testName, int count)
+{
+    int kidpid, status;
+
+    for (int i = 0; i < count; i++)
+    {
+        kidpid = k_wait(&status);
+        console_output(FALSE, "%s: Exit status for child %s is %d\n", testName, childNames[kidpid], status);
+    }
+}
+
+/*********************************************************************************
+* Delayer
+*
+* Delays DELAY_MS and reports how long it took and how much CPU it used.
+*********************************************************************************/
+int Delayer(char* strArgs)
+{
+    DWORD startTime, endTime;
+    int startCpu, endCpu;
+
+    console_output(FALSE, "%s: started\n", strArgs);
+
+    startCpu = read_time();
+    startTime = read_clock();
+    SystemDelay(DELAY_MS);
+    endTime = read_clock();
+    endCpu = read_time();
+    delayerDone = 1;
+
+    console_output(FALSE, "%s: delayed at least %d ms: %s\n", strArgs, DELAY_MS,
+        (endTime - startTime) / 1000 >= DELAY_MS ? "yes" : "no");
+    console_output(FALSE, "%s: used under a tenth of it as CPU time: %s\n", strArgs,
+        endCpu - startCpu < DELAY_MS / 10 ? "yes" : "no");
+
+    k_exit(-3);
+    return 0;
+}
+
+/*********************************************************************************
+* Worker
+*
+* Reports whether it ran before the delay it is lower priority than ended.
+*********************************************************************************/
+int Worker(char* strArgs)
+{
+    console_output(FALSE, "%s: started\n", strArgs);
+    console_output(FALSE, "%s: ran during the delay: %s\n", strArgs, delayerDone ? "no" : "yes");
+
+    k_exit(-4);
+    return 0;
+}
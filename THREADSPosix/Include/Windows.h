@@ -0,0 +1,28 @@
+#pragma once
+/* Minimal stand-in for <Windows.h> used by the POSIX host build of THREADS.
+ * Only the handful of types and macros the THREADS headers and the
+ * messaging sources rely on are provided here. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef uint32_t DWORD;
+typedef int      BOOL;
+typedef void*    LPVOID;
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define __declspec(x)
+
+typedef int32_t  LONG;
+
+/* winnt.h acquire/release accessors */
+#define ReadAcquire(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define WriteRelease(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
@@ -0,0 +1,25 @@
+###########################################################################
+#   RunBenchmarks.cmake
+#   Runs each benchmark in PROGRAMS and writes the BENCH lines they print
+#   to RESULTS.  Used by the run_benchmarks target.
+###########################################################################
+file(WRITE ${RESULTS} "")
+
+foreach(program IN LISTS PROGRAMS)
+    get_filename_component(name ${program} NAME)
+    message(STATUS "Running ${name}")
+    execute_process(COMMAND ${program}
+        OUTPUT_VARIABLE output
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(WARNING "${name} exited with ${result}")
+    endif()
+
+    string(REGEX MATCHALL "BENCH [^\n]*" lines "${output}")
+    foreach(line IN LISTS lines)
+        message("${line}")
+        file(APPEND ${RESULTS} "${line}\n")
+    endforeach()
+endforeach()
+
+message(STATUS "Results written to ${RESULTS}")
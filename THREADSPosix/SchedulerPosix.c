@@ -0,0 +1,640 @@
+///////////////////////////////////////////////////////////////////////////
+//   SchedulerPosix.c
+//   POSIX host implementation of the THREADS scheduler (Scheduler.h):
+//   preemptive priority scheduling with round-robin time slicing inside
+//   a priority level, parent/child wait and join, signals, and a
+//   watchdog process that idles the CPU and detects deadlock.
+///////////////////////////////////////////////////////////////////////////
+#define _GNU_SOURCE
+#include <Windows.h>
+#include <stdio.h>
+#include <signal.h>
+#include <THREADSLib.h>
+#include <Scheduler.h>
+
+/* -------------------------- Constants ----------------------------------- */
+#define TIME_SLICE_USEC     80000
+#define WATCHDOG_PRIORITY   LOWEST_PRIORITY
+
+#define STATUS_EMPTY        0
+#define STATUS_READY        1
+#define STATUS_RUNNING      2
+#define STATUS_BLOCKED      3
+#define STATUS_QUIT         4
+
+/* Internal block reasons; block() callers must use values above 10. */
+#define BLOCKED_WAIT        1
+#define BLOCKED_JOIN        2
+
+/* -------------------------- Types --------------------------------------- */
+typedef struct process
+{
+    struct process* pNextReady;
+    char            name[MAXNAME];
+    int             pid;
+    int             parentPid;
+    int             priority;
+    int             status;
+    int             blockStatus;
+    int             signaled;
+    int             exitCode;
+    int             quitOrder;
+    int             joinPid;
+    void*           context;
+    int             (*entryPoint)(void*);
+    void*           args;
+    char            argBuffer[MAXARG];
+    uint32_t        startTime;
+    uint32_t        cpuTime;
+    uint32_t        sliceStart;
+} Process;
+
+/* -------------------------- Globals ------------------------------------- */
+check_io_function check_io;
+
+static Process processTable[MAXPROC];
+static Process* readyHead[HIGHEST_PRIORITY + 1];
+static Process* readyTail[HIGHEST_PRIORITY + 1];
+static Process* runningProcess = NULL;
+static int nextPid = 1;
+static int quitCounter = 0;
+static void* pendingStop = NULL;
+
+extern int SchedulerEntryPoint(void* pArgs);
+
+/* ------------------------- Prototypes ----------------------------------- */
+static int check_io_default(void);
+static int launch(void* pArgs);
+static int watchdog(void* pArgs);
+static void ready_push(Process* p);
+static Process* ready_pop(void);
+static int spawn_process(char* name, int (*entryPoint)(void*), void* arg, int stacksize, int priority);
+static void make_ready(Process* p);
+
+static int check_io_default(void)
+{
+    return 0;
+}
+
+static uint32_t disable_saved(void)
+{
+    uint32_t psr = get_psr();
+    set_psr(psr & ~PSR_INTERRUPTS);
+    return psr;
+}
+
+static void restore_saved(uint32_t psr)
+{
+    set_psr(psr);
+}
+
+void enableInterrupts()
+{
+    set_psr(get_psr() | PSR_INTERRUPTS);
+}
+
+void disableInterrupts()
+{
+    set_psr(get_psr() & ~PSR_INTERRUPTS);
+}
+
+DWORD read_clock(void)
+{
+    return system_clock();
+}
+
+/* ------------------------------------------------------------------------
+   Ready lists
+   ----------------------------------------------------------------------- */
+static void ready_push(Process* p)
+{
+    p->pNextReady = NULL;
+    if (readyTail[p->priority])
+        readyTail[p->priority]->pNextReady = p;
+    else
+        readyHead[p->priority] = p;
+    readyTail[p->priority] = p;
+}
+
+static Process* ready_pop(void)
+{
+    for (int pri = HIGHEST_PRIORITY; pri >= LOWEST_PRIORITY; pri--)
+    {
+        Process* p = readyHead[pri];
+        if (p)
+        {
+            readyHead[pri] = p->pNextReady;
+            if (readyHead[pri] == NULL)
+                readyTail[pri] = NULL;
+            p->pNextReady = NULL;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static int highest_ready_priority(void)
+{
+    for (int pri = HIGHEST_PRIORITY; pri >= LOWEST_PRIORITY; pri--)
+    {
+        if (readyHead[pri])
+            return pri;
+    }
+    return -1;
+}
+
+/* ------------------------------------------------------------------------
+   Dispatcher
+   ----------------------------------------------------------------------- */
+void dispatcher()
+{
+    uint32_t psr = disable_saved();
+    Process* current = runningProcess;
+    Process* next;
+    uint32_t now = system_clock();
+
+    if (current && current->status == STATUS_RUNNING)
+    {
+        /* Keep running unless something strictly more important is ready. */
+        if (highest_ready_priority() <= current->priority)
+        {
+            restore_saved(psr);
+            return;
+        }
+        current->status = STATUS_READY;
+        ready_push(current);
+    }
+
+    next = ready_pop();
+    if (next == NULL)
+    {
+        console_output(FALSE, "dispatcher: no runnable process. Halting...\n");
+        stop(1);
+    }
+
+    if (current)
+        current->cpuTime += now - current->sliceStart;
+
+    next->status = STATUS_RUNNING;
+    next->sliceStart = now;
+    runningProcess = next;
+
+    if (next != current)
+        context_switch(next->context);
+
+    /* Back on this process's stack; release any context that quit. */
+    if (pendingStop && (current == NULL || pendingStop != current->context))
+    {
+        context_stop(pendingStop);
+        pendingStop = NULL;
+    }
+    restore_saved(psr);
+}
+
+void time_slice(void)
+{
+    Process* current = runningProcess;
+
+    if (current == NULL || current->status != STATUS_RUNNING)
+        return;
+
+    if (system_clock() - current->sliceStart >= TIME_SLICE_USEC &&
+        readyHead[current->priority] != NULL)
+    {
+        current->cpuTime += system_clock() - current->sliceStart;
+        current->status = STATUS_READY;
+        ready_push(current);
+        Process* next = ready_pop();
+        next->status = STATUS_RUNNING;
+        next->sliceStart = system_clock();
+        runningProcess = next;
+        if (next != current)
+            context_switch(next->context);
+    }
+}
+
+/* ------------------------------------------------------------------------
+   Process lifecycle
+   ----------------------------------------------------------------------- */
+static int launch(void* pArgs)
+{
+    Process* p = (Process*)pArgs;
+    int rc;
+
+    enableInterrupts();
+    rc = p->entryPoint(p->args);
+    k_exit(rc);
+    return rc;
+}
+
+static int spawn_process(char* name, int (*entryPoint)(void*), void* arg, int stacksize, int priority)
+{
+    Process* p = NULL;
+
+    for (int tries = 0; tries < MAXPROC; tries++)
+    {
+        int pid = nextPid;
+        nextPid = (nextPid + 1) % MAXPROC;
+        if (nextPid == 0)
+            nextPid = 1;
+        if (processTable[pid].status == STATUS_EMPTY)
+        {
+            p = &processTable[pid];
+            p->pid = pid;
+            break;
+        }
+    }
+
+    if (p == NULL)
+        return -4;
+
+    strncpy(p->name, name ? name : "", MAXNAME - 1);
+    p->name[MAXNAME - 1] = '\0';
+    p->parentPid = runningProcess ? runningProcess->pid : 0;
+    p->priority = priority;
+    p->blockStatus = 0;
+    p->signaled = 0;
+    p->exitCode = 0;
+    p->quitOrder = 0;
+    p->joinPid = -1;
+    p->entryPoint = entryPoint;
+    /* Like the THREADS scheduler, the argument is copied as a string so
+       callers may reuse their buffer as soon as k_spawn returns. */
+    p->args = NULL;
+    if (arg != NULL)
+    {
+        strncpy(p->argBuffer, (char*)arg, MAXARG - 1);
+        p->argBuffer[MAXARG - 1] = '\0';
+        p->args = p->argBuffer;
+    }
+    p->startTime = system_clock();
+    p->cpuTime = 0;
+    p->context = context_initialize(launch, stacksize, p);
+    if (p->context == NULL)
+    {
+        p->status = STATUS_EMPTY;
+        return -1;
+    }
+
+    p->status = STATUS_READY;
+    ready_push(p);
+    return p->pid;
+}
+
+int k_spawn(char* name, int(*entryPoint)(void*), void* arg, int stacksize, int priority)
+{
+    uint32_t psr;
+    int pid;
+
+    if (entryPoint == NULL || stacksize < THREADS_MIN_STACK_SIZE)
+        return -2;
+    if (priority <= LOWEST_PRIORITY || priority > HIGHEST_PRIORITY)
+        return -3;
+
+    psr = disable_saved();
+    pid = spawn_process(name, entryPoint, arg, stacksize, priority);
+    if (pid >= 0)
+        dispatcher();
+    restore_saved(psr);
+    return pid;
+}
+
+void k_exit(int exitCode)
+{
+    Process* me;
+
+    disableInterrupts();
+    me = runningProcess;
+    me->exitCode = exitCode;
+    me->status = STATUS_QUIT;
+    me->quitOrder = ++quitCounter;
+    me->cpuTime += system_clock() - me->sliceStart;
+
+    /* Children that outlive their parent are orphaned. */
+    for (int i = 0; i < MAXPROC; i++)
+    {
+        if (processTable[i].status != STATUS_EMPTY && processTable[i].parentPid == me->pid &&
+            &processTable[i] != me)
+        {
+            processTable[i].parentPid = 0;
+            if (processTable[i].status == STATUS_QUIT)
+            {
+                context_stop(processTable[i].context);
+                processTable[i].context = NULL;
+                processTable[i].status = STATUS_EMPTY;
+            }
+        }
+    }
+
+    for (int i = 0; i < MAXPROC; i++)
+    {
+        Process* p = &processTable[i];
+        if (p->status != STATUS_BLOCKED)
+            continue;
+        if ((p->blockStatus == BLOCKED_WAIT && p->pid == me->parentPid) ||
+            (p->blockStatus == BLOCKED_JOIN && p->joinPid == me->pid))
+        {
+            make_ready(p);
+        }
+    }
+
+    if (me->parentPid == 0)
+    {
+        /* Nobody will reap an orphan; reclaim it once off its stack. */
+        if (pendingStop)
+            context_stop(pendingStop);
+        pendingStop = me->context;
+        me->context = NULL;
+        me->status = STATUS_EMPTY;
+    }
+
+    runningProcess = NULL;
+    dispatcher();
+
+    /* Not reached. */
+    stop(1);
+}
+
+static Process* find_quit_child(int parentPid)
+{
+    Process* found = NULL;
+
+    for (int i = 0; i < MAXPROC; i++)
+    {
+        Process* p = &processTable[i];
+        if (p->status == STATUS_QUIT && p->parentPid == parentPid)
+        {
+            if (found == NULL || p->quitOrder < found->quitOrder)
+                found = p;
+        }
+    }
+    return found;
+}
+
+static int has_children(int parentPid)
+{
+    for (int i = 0; i < MAXPROC; i++)
+    {
+        if (processTable[i].status != STATUS_EMPTY && processTable[i].parentPid == parentPid &&
+            processTable[i].pid != parentPid)
+            return 1;
+    }
+    return 0;
+}
+
+int k_wait(int* pChildExitCode)
+{
+    uint32_t psr = disable_saved();
+    Process* me = runningProcess;
+    Process* child;
+
+    while ((child = find_quit_child(me->pid)) == NULL)
+    {
+        if (!has_children(me->pid))
+        {
+            restore_saved(psr);
+            return -4;
+        }
+        if (me->signaled)
+        {
+            restore_saved(psr);
+            return -5;
+        }
+        me->status = STATUS_BLOCKED;
+        me->blockStatus = BLOCKED_WAIT;
+        dispatcher();
+        disableInterrupts();
+    }
+
+    int pid = child->pid;
+    if (pChildExitCode)
+        *pChildExitCode = child->exitCode;
+    context_stop(child->context);
+    child->status = STATUS_EMPTY;
+    child->context = NULL;
+
+    restore_saved(psr);
+    return pid;
+}
+
+int k_join(int pid, int* pChildExitCode)
+{
+    uint32_t psr = disable_saved();
+    Process* me = runningProcess;
+
+    if (pid <= 0 || pid >= MAXPROC || processTable[pid].status == STATUS_EMPTY || pid == me->pid)
+    {
+        restore_saved(psr);
+        return -1;
+    }
+
+    while (processTable[pid].status != STATUS_QUIT && processTable[pid].status != STATUS_EMPTY)
+    {
+        if (me->signaled)
+        {
+            restore_saved(psr);
+            return -5;
+        }
+        me->status = STATUS_BLOCKED;
+        me->blockStatus = BLOCKED_JOIN;
+        me->joinPid = pid;
+        dispatcher();
+        disableInterrupts();
+    }
+    me->joinPid = -1;
+
+    if (pChildExitCode)
+        *pChildExitCode = processTable[pid].exitCode;
+    restore_saved(psr);
+    return 0;
+}
+
+int k_kill(int pid, int signal)
+{
+    uint32_t psr = disable_saved();
+
+    if (pid <= 0 || pid >= MAXPROC || processTable[pid].status == STATUS_EMPTY ||
+        processTable[pid].status == STATUS_QUIT || signal != SIG_TERM)
+    {
+        restore_saved(psr);
+        return -1;
+    }
+
+    Process* p = &processTable[pid];
+    p->signaled = 1;
+    if (p->status == STATUS_BLOCKED && (p->blockStatus == BLOCKED_WAIT || p->blockStatus == BLOCKED_JOIN))
+    {
+        make_ready(p);
+        dispatcher();
+    }
+
+    restore_saved(psr);
+    return 0;
+}
+
+int k_getpid(void)
+{
+    return runningProcess ? runningProcess->pid : -1;
+}
+
+int signaled(void)
+{
+    return runningProcess ? runningProcess->signaled : 0;
+}
+
+/* ------------------------------------------------------------------------
+   block / unblock
+   ----------------------------------------------------------------------- */
+static void make_ready(Process* p)
+{
+    p->status = STATUS_READY;
+    p->blockStatus = 0;
+    ready_push(p);
+}
+
+int block(int block_status)
+{
+    uint32_t psr = disable_saved();
+    Process* me = runningProcess;
+
+    if (block_status <= 10)
+    {
+        restore_saved(psr);
+        return -1;
+    }
+
+    me->status = STATUS_BLOCKED;
+    me->blockStatus = block_status;
+    dispatcher();
+
+    restore_saved(psr);
+    return me->signaled ? -5 : 0;
+}
+
+int unblock(int pid)
+{
+    uint32_t psr = disable_saved();
+
+    if (pid <= 0 || pid >= MAXPROC || processTable[pid].status != STATUS_BLOCKED ||
+        processTable[pid].blockStatus <= 10)
+    {
+        restore_saved(psr);
+        return -1;
+    }
+
+    make_ready(&processTable[pid]);
+    dispatcher();
+
+    restore_saved(psr);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+   Timing and diagnostics
+   ----------------------------------------------------------------------- */
+int read_time(void)
+{
+    Process* p = runningProcess;
+
+    if (p == NULL)
+        return 0;
+    return (int)((p->cpuTime + (system_clock() - p->sliceStart)) / 1000);
+}
+
+int get_start_time(void)
+{
+    return runningProcess ? (int)runningProcess->startTime : 0;
+}
+
+void display_process_table(void)
+{
+    static const char* statusNames[] = { "EMPTY", "READY", "RUNNING", "BLOCKED", "QUIT" };
+    uint32_t psr = disable_saved();
+
+    console_output(FALSE, "%-5s %-6s %-8s %-10s %-8s %s\n", "PID", "Parent", "Priority", "Status", "CPU(ms)", "Name");
+    for (int i = 0; i < MAXPROC; i++)
+    {
+        Process* p = &processTable[i];
+        if (p->status == STATUS_EMPTY)
+            continue;
+        if (p->status == STATUS_BLOCKED)
+        {
+            console_output(FALSE, "%-5d %-6d %-8d %-7s%3d %-8u %s\n", p->pid, p->parentPid, p->priority,
+                statusNames[p->status], p->blockStatus, p->cpuTime / 1000, p->name);
+        }
+        else
+        {
+            console_output(FALSE, "%-5d %-6d %-8d %-10s %-8u %s\n", p->pid, p->parentPid, p->priority,
+                statusNames[p->status], p->cpuTime / 1000, p->name);
+        }
+    }
+    restore_saved(psr);
+}
+
+/* ------------------------------------------------------------------------
+   Watchdog: lowest priority process.  Idles until the next interrupt,
+   stops the system when every process has quit, and halts on deadlock.
+   ----------------------------------------------------------------------- */
+static int watchdog(void* pArgs)
+{
+    sigset_t empty;
+
+    (void)pArgs;
+    sigemptyset(&empty);
+
+    while (1)
+    {
+        int live = 0;
+
+        disableInterrupts();
+        for (int i = 0; i < MAXPROC; i++)
+        {
+            Process* p = &processTable[i];
+            if (p != runningProcess && (p->status == STATUS_READY || p->status == STATUS_RUNNING ||
+                p->status == STATUS_BLOCKED))
+                live++;
+        }
+
+        if (live == 0)
+        {
+            console_output(FALSE, "All processes completed.\n");
+            stop(0);
+        }
+
+        if (highest_ready_priority() < 0 && !check_io())
+        {
+            console_output(FALSE, "watchdog: all processes blocked and no I/O pending. Halting...\n");
+            display_process_table();
+            stop(1);
+        }
+
+        enableInterrupts();
+        sigsuspend(&empty);
+    }
+    return 0;
+}
+
+int bootstrap(void* pArgs)
+{
+    (void)pArgs;
+
+    check_io = check_io_default;
+    set_psr(PSR_KERNEL_MODE);
+
+    for (int i = 0; i < MAXPROC; i++)
+        processTable[i].status = STATUS_EMPTY;
+
+    /* pid 0 is never handed out; the watchdog takes slot MAXPROC - 1. */
+    processTable[MAXPROC - 1].pid = MAXPROC - 1;
+    nextPid = MAXPROC - 1;
+    spawn_process("watchdog", watchdog, NULL, THREADS_MIN_STACK_SIZE, WATCHDOG_PRIORITY);
+    nextPid = 1;
+
+    spawn_process("SchedulerEntryPoint", SchedulerEntryPoint, NULL, THREADS_MIN_STACK_SIZE, HIGHEST_PRIORITY);
+
+    dispatcher();
+
+    /* Not reached. */
+    stop(1);
+    return 0;
+}
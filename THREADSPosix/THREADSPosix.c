@@ -0,0 +1,542 @@
+///////////////////////////////////////////////////////////////////////////
+//   THREADSPosix.c
+//   POSIX host implementation of the THREADS hardware interface
+//   (THREADSLib.h).  Contexts are ucontext_t stacks, the interrupt source
+//   is a 1ms SIGALRM interval timer, and devices are simulated in memory
+//   with terminals backed by terminalN_input.txt / terminalN_output.txt.
+///////////////////////////////////////////////////////////////////////////
+#define _GNU_SOURCE
+#include <Windows.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <THREADSLib.h>
+
+/* -------------------------- Constants ----------------------------------- */
+#define HW_TICK_USEC            1000    /* interval timer resolution */
+#define CLOCK_INTERRUPT_USEC    20000   /* THREADS clock interrupt period */
+#define TERMINAL_LATENCY_USEC   1000    /* one character per millisecond */
+#define DISK_LATENCY_USEC       3000
+#define POSIX_MIN_STACK         (256 * 1024)
+#define DEVICE_QUEUE_DEPTH      64
+
+/* Device handles.  The clock is fixed at THREADS_CLOCK_DEVICE_ID and the
+ * system call pseudo-device at THREADS_SYSTEM_CALL_ID. */
+#define DISK0_HANDLE            1
+#define TERM0_HANDLE            3
+
+/* -------------------------- Types --------------------------------------- */
+typedef struct
+{
+    ucontext_t  uc;
+    void*       stack;
+    size_t      stackSize;
+    uint32_t    psr;
+    process_entrypoint_t entryPoint;
+    void*       args;
+} PosixContext;
+
+typedef struct
+{
+    uint8_t  command;
+    uint32_t status;
+    uint32_t completeAt;
+} DeviceOperation;
+
+typedef struct
+{
+    const char*     name;
+    device_type_t   type;
+    int             initialized;
+    DeviceOperation queue[DEVICE_QUEUE_DEPTH];
+    int             head;
+    int             count;
+    FILE*           input;
+    FILE*           output;
+    int             track;
+    unsigned char*  storage;
+} PosixDevice;
+
+/* -------------------------- Globals ------------------------------------- */
+static interrupt_handler_t g_handlers[THREADS_INTERRUPT_HANDLER_COUNT];
+static volatile uint32_t g_psr = PSR_KERNEL_MODE;
+static volatile sig_atomic_t g_hwPending = 0;
+static PosixContext* g_current = NULL;
+static PosixContext g_mainContext;
+static struct timespec g_startTime;
+static uint32_t g_nextClockInterrupt = CLOCK_INTERRUPT_USEC;
+static int g_debugLevel = 0;
+static sigset_t g_alarmSet;
+
+static PosixDevice g_devices[THREADS_MAX_DEVICES] = {
+    { .name = "clock",   .type = DEVICE_CLOCK },
+    { .name = "disk0",   .type = DEVICE_DISK },
+    { .name = "disk1",   .type = DEVICE_DISK },
+    { .name = "term0",   .type = DEVICE_TERMINAL },
+    { .name = "term1",   .type = DEVICE_TERMINAL },
+    { .name = "term2",   .type = DEVICE_TERMINAL },
+    { .name = "term3",   .type = DEVICE_TERMINAL },
+    { .name = "syscall", .type = DEVICE_CLOCK },
+};
+
+extern int bootstrap(void* pArgs);
+
+/* ------------------------- Prototypes ----------------------------------- */
+static void deliver_interrupts(void);
+static void alarm_handler(int sig);
+static void context_trampoline(void);
+
+/* ------------------------------------------------------------------------
+   Interrupt masking for host-side critical sections.  The simulated PSR
+   governs what THREADS code sees; this only keeps the host C library
+   from being re-entered from the timer signal.
+   ----------------------------------------------------------------------- */
+static void host_block(sigset_t* old)
+{
+    sigprocmask(SIG_BLOCK, &g_alarmSet, old);
+}
+
+static void host_restore(sigset_t* old)
+{
+    sigprocmask(SIG_SETMASK, old, NULL);
+}
+
+uint32_t system_clock()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - g_startTime.tv_sec) * 1000000LL +
+        (now.tv_nsec - g_startTime.tv_nsec) / 1000);
+}
+
+uint32_t get_psr()
+{
+    return g_psr;
+}
+
+void set_psr(uint32_t psr)
+{
+    g_psr = psr;
+
+    /* Interrupts that arrived while disabled are delivered on enable. */
+    while ((g_psr & PSR_INTERRUPTS) && g_hwPending)
+    {
+        deliver_interrupts();
+    }
+}
+
+interrupt_handler_t* get_interrupt_handlers()
+{
+    return g_handlers;
+}
+
+/* ------------------------------------------------------------------------
+   Contexts
+   ----------------------------------------------------------------------- */
+static void context_trampoline(void)
+{
+    PosixContext* ctx = g_current;
+    int rc = ctx->entryPoint(ctx->args);
+
+    console_output(FALSE, "THREADS: context returned %d without exiting. Halting...\n", rc);
+    stop(1);
+}
+
+void* context_initialize(process_entrypoint_t entry_point, int stack_size, void* args)
+{
+    sigset_t old;
+    PosixContext* volatile ctx;     /* live across getcontext, which may return twice */
+
+    host_block(&old);
+    ctx = calloc(1, sizeof(PosixContext));
+    if (ctx == NULL)
+    {
+        host_restore(&old);
+        return NULL;
+    }
+
+    /* Host libc frames are far larger than the Windows fibers THREADS_MIN_STACK_SIZE
+       was tuned for, so every context gets at least POSIX_MIN_STACK. */
+    ctx->stackSize = stack_size < POSIX_MIN_STACK ? POSIX_MIN_STACK : (size_t)stack_size;
+    ctx->stack = mmap(NULL, ctx->stackSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (ctx->stack == MAP_FAILED)
+    {
+        free(ctx);
+        host_restore(&old);
+        return NULL;
+    }
+
+    ctx->entryPoint = entry_point;
+    ctx->args = args;
+    ctx->psr = PSR_KERNEL_MODE;
+
+    getcontext(&ctx->uc);
+    ctx->uc.uc_stack.ss_sp = ctx->stack;
+    ctx->uc.uc_stack.ss_size = ctx->stackSize;
+    ctx->uc.uc_link = NULL;
+    sigdelset(&ctx->uc.uc_sigmask, SIGALRM);
+    makecontext(&ctx->uc, context_trampoline, 0);
+
+    host_restore(&old);
+    return ctx;
+}
+
+bool context_switch(LPVOID next_context)
+{
+    PosixContext* next = (PosixContext*)next_context;
+    PosixContext* prev;
+    sigset_t old;
+
+    if (next == NULL)
+        return false;
+
+    host_block(&old);
+    prev = g_current != NULL ? g_current : &g_mainContext;
+    if (prev == next)
+    {
+        host_restore(&old);
+        return true;
+    }
+
+    prev->psr = g_psr;
+    g_current = next;
+    g_psr = next->psr;
+    swapcontext(&prev->uc, &next->uc);
+
+    /* Resumed: restore this context's own signal mask. */
+    host_restore(&old);
+    return true;
+}
+
+void context_stop(LPVOID context)
+{
+    PosixContext* ctx = (PosixContext*)context;
+    sigset_t old;
+
+    if (ctx == NULL || ctx == g_current)
+        return;
+
+    host_block(&old);
+    munmap(ctx->stack, ctx->stackSize);
+    free(ctx);
+    host_restore(&old);
+}
+
+/* ------------------------------------------------------------------------
+   Devices
+   ----------------------------------------------------------------------- */
+static int find_device(const char* device)
+{
+    if (device == NULL)
+        return -1;
+
+    for (int i = 0; i < THREADS_MAX_DEVICES; i++)
+    {
+        if (strcmp(g_devices[i].name, device) == 0)
+            return i;
+    }
+    return -1;
+}
+
+uint32_t device_initialize(char* device)
+{
+    int h = find_device(device);
+    char fileName[64];
+
+    if (h < 0 || h == THREADS_SYSTEM_CALL_ID)
+        return (uint32_t)-1;
+
+    PosixDevice* d = &g_devices[h];
+    if (!d->initialized)
+    {
+        if (d->type == DEVICE_TERMINAL)
+        {
+            snprintf(fileName, sizeof(fileName), "terminal%d_input.txt", h - TERM0_HANDLE);
+            d->input = fopen(fileName, "r");
+            snprintf(fileName, sizeof(fileName), "terminal%d_output.txt", h - TERM0_HANDLE);
+            d->output = fopen(fileName, "w");
+        }
+        else if (d->type == DEVICE_DISK)
+        {
+            d->storage = calloc((size_t)THREADS_DISK_MAX_TRACKS * THREADS_DISK_SECTOR_COUNT,
+                THREADS_DISK_SECTOR_SIZE);
+        }
+        d->initialized = 1;
+    }
+    return (uint32_t)h;
+}
+
+uint32_t device_handle(char* device)
+{
+    int h = find_device(device);
+
+    if (h < 0 || !g_devices[h].initialized)
+        return (uint32_t)-1;
+    return (uint32_t)h;
+}
+
+static uint32_t terminal_operation(PosixDevice* d, device_control_block_t* cb)
+{
+    int ch = 0;
+
+    if (cb->command == TERMINAL_WRITE_CHAR)
+    {
+        ch = (int)(uintptr_t)cb->output_data & 0xFF;
+        if (d->output)
+        {
+            fputc(ch, d->output);
+            fflush(d->output);
+        }
+    }
+    else if (cb->command == TERMINAL_READ_CHAR)
+    {
+        ch = d->input ? fgetc(d->input) : EOF;
+        if (ch == EOF)
+            return 0;
+        if (cb->input_data)
+            *(char*)cb->input_data = (char)ch;
+        if (d->output)
+        {
+            fputc(ch, d->output);
+            fflush(d->output);
+        }
+    }
+    return ((uint32_t)ch << 8) | 1;
+}
+
+static uint32_t disk_operation(PosixDevice* d, device_control_block_t* cb)
+{
+    size_t offset;
+    size_t length = cb->data_length;
+    unsigned int track = cb->control1;
+    size_t capacity = (size_t)THREADS_DISK_MAX_TRACKS * THREADS_DISK_SECTOR_COUNT * THREADS_DISK_SECTOR_SIZE;
+
+    switch (cb->command)
+    {
+    case DISK_INFO:
+        if (cb->output_data)
+            *(uint32_t*)cb->output_data = THREADS_DISK_MAX_TRACKS;
+        return 0;
+    case DISK_SEEK:
+        if (track >= THREADS_DISK_MAX_TRACKS)
+            return 1;
+        d->track = (int)track;
+        return 0;
+    case DISK_READ:
+    case DISK_WRITE:
+        offset = ((size_t)d->track * THREADS_DISK_SECTOR_COUNT + cb->control2) * THREADS_DISK_SECTOR_SIZE;
+        if (length == 0)
+            length = THREADS_DISK_SECTOR_SIZE;
+        if (d->storage == NULL || offset + length > capacity)
+            return 1;
+        if (cb->command == DISK_READ && cb->input_data)
+            memcpy(cb->input_data, d->storage + offset, length);
+        else if (cb->command == DISK_WRITE && cb->output_data)
+            memcpy(d->storage + offset, cb->output_data, length);
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+uint32_t device_control(char* device, device_control_block_t control_block)
+{
+    int h = find_device(device);
+    sigset_t old;
+    uint32_t status;
+    uint32_t latency;
+
+    if (h < 0 || !g_devices[h].initialized || g_devices[h].type == DEVICE_CLOCK)
+        return (uint32_t)-1;
+
+    PosixDevice* d = &g_devices[h];
+
+    host_block(&old);
+    if (d->count >= DEVICE_QUEUE_DEPTH)
+    {
+        host_restore(&old);
+        return (uint32_t)-1;
+    }
+
+    if (d->type == DEVICE_TERMINAL)
+    {
+        status = terminal_operation(d, &control_block);
+        latency = TERMINAL_LATENCY_USEC;
+    }
+    else
+    {
+        status = disk_operation(d, &control_block);
+        latency = DISK_LATENCY_USEC;
+    }
+
+    /* Operations on one device complete one after another. */
+    uint32_t start = system_clock();
+    if (d->count > 0)
+    {
+        uint32_t last = d->queue[(d->head + d->count - 1) % DEVICE_QUEUE_DEPTH].completeAt;
+        if (last > start)
+            start = last;
+    }
+
+    DeviceOperation* op = &d->queue[(d->head + d->count) % DEVICE_QUEUE_DEPTH];
+    op->command = control_block.command;
+    op->status = status;
+    op->completeAt = start + latency;
+    d->count++;
+    host_restore(&old);
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+   Interrupts
+   ----------------------------------------------------------------------- */
+static void deliver_interrupts(void)
+{
+    uint32_t savedPsr = g_psr;
+    uint32_t now;
+
+    g_hwPending = 0;
+    g_psr = PSR_KERNEL_MODE | PSR_IRQ_MODE;
+    now = system_clock();
+
+    if (now >= g_nextClockInterrupt)
+    {
+        while (g_nextClockInterrupt <= now)
+            g_nextClockInterrupt += CLOCK_INTERRUPT_USEC;
+
+        if (g_handlers[THREADS_TIMER_INTERRUPT])
+            g_handlers[THREADS_TIMER_INTERRUPT]((char*)(uintptr_t)THREADS_CLOCK_DEVICE_ID, 0, 0, NULL);
+    }
+
+    for (int h = 0; h < THREADS_MAX_DEVICES; h++)
+    {
+        PosixDevice* d = &g_devices[h];
+
+        while (d->count > 0 && d->queue[d->head].completeAt <= now)
+        {
+            DeviceOperation op = d->queue[d->head];
+            d->head = (d->head + 1) % DEVICE_QUEUE_DEPTH;
+            d->count--;
+
+            if (g_handlers[THREADS_IO_INTERRUPT])
+                g_handlers[THREADS_IO_INTERRUPT]((char*)(uintptr_t)h, op.command, op.status, NULL);
+        }
+    }
+
+    g_psr = savedPsr;
+}
+
+static void alarm_handler(int sig)
+{
+    (void)sig;
+
+    g_hwPending = 1;
+    if (g_psr & PSR_INTERRUPTS)
+    {
+        while ((g_psr & PSR_INTERRUPTS) && g_hwPending)
+        {
+            deliver_interrupts();
+        }
+    }
+}
+
+void system_call(system_call_arguments_t* sys_args)
+{
+    uint32_t savedPsr = g_psr;
+
+    g_psr = (savedPsr & PSR_INTERRUPTS) | PSR_KERNEL_MODE;
+    if (g_handlers[THREADS_SYS_CALL_INTERRUPT])
+        g_handlers[THREADS_SYS_CALL_INTERRUPT]((char*)(uintptr_t)THREADS_SYSTEM_CALL_ID, SYSTEM_CALL, 0, sys_args);
+    set_psr(savedPsr);
+}
+
+/* ------------------------------------------------------------------------
+   Console and shutdown
+   ----------------------------------------------------------------------- */
+void set_debug_level(int level)
+{
+    g_debugLevel = level;
+}
+
+void console_output(bool debug, char* string, ...)
+{
+    va_list args;
+    sigset_t old;
+
+    if (debug && g_debugLevel == 0)
+        return;
+
+    host_block(&old);
+    va_start(args, string);
+    vprintf(string, args);
+    va_end(args);
+    fflush(stdout);
+    host_restore(&old);
+}
+
+void stop(int code)
+{
+    sigset_t old;
+
+    host_block(&old);
+    fflush(stdout);
+    for (int i = 0; i < THREADS_MAX_DEVICES; i++)
+    {
+        if (g_devices[i].output)
+            fclose(g_devices[i].output);
+        if (g_devices[i].input)
+            fclose(g_devices[i].input);
+    }
+    exit(code);
+}
+
+/* ------------------------------------------------------------------------
+   Host entry point (THREADSMain)
+   ----------------------------------------------------------------------- */
+int main(int argc, char* argv[])
+{
+    struct sigaction sa;
+    struct itimerval timer;
+    void* bootContext;
+
+    (void)argc;
+    (void)argv;
+
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    clock_gettime(CLOCK_MONOTONIC, &g_startTime);
+    sigemptyset(&g_alarmSet);
+    sigaddset(&g_alarmSet, SIGALRM);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = alarm_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+
+    g_devices[THREADS_CLOCK_DEVICE_ID].initialized = 1;
+
+    bootContext = context_initialize(bootstrap, THREADS_MIN_STACK_SIZE, NULL);
+    if (bootContext == NULL)
+    {
+        fprintf(stderr, "THREADS: unable to create bootstrap context\n");
+        return 1;
+    }
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = HW_TICK_USEC;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    context_switch(bootContext);
+
+    /* bootstrap never returns control to the host thread. */
+    stop(1);
+    return 1;
+}
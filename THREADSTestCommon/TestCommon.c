@@ -231,27 +231,17 @@ char* GetTestName(char* filename)
 *
 *  SystemDelay
 *
-*  Busy-wait delay for the specified duration in milliseconds. Uses
-*  read_clock() for timing. Optimization is disabled to prevent the
-*  compiler from eliminating the spin loop.
+*  Delay for the specified duration in milliseconds. The caller blocks in
+*  k_sleep, so the processes it is waiting for get the CPU.
 *
 *  Parameters:
 *    millisTime - duration to delay in milliseconds
 *
 *********************************************************************************/
-#pragma optimize( "", off )
 void SystemDelay(int millisTime)
 {
-    unsigned int startTime;
-    unsigned int currentTime;
-
-    currentTime = startTime = read_clock() / 1000;
-    while ((currentTime - startTime) < (unsigned int)millisTime)
-    {
-        currentTime = read_clock() / 1000;
-    }
+    k_sleep(millisTime);
 }
-#pragma optimize( "", on )
 
 /*********************************************************************************
 *
@@ -260,6 +250,7 @@ void SystemDelay(int millisTime)
 *  Child process that runs for ~10 seconds. If the trailing number in its
 *  name is divisible by 4, it periodically calls display_process_table()
 *  (every ~5 seconds starting at 2.5s). All instances exit after 10 seconds.
+*  Between those points it sleeps in k_sleep rather than spinning.
 *
 *  Exits with code -(pid).
 *
@@ -273,6 +264,7 @@ int DelayAndDump(char* arg)
     int printingThread = 0;
     unsigned long  printAt = 2500;
     unsigned long  stopAt = 10000;
+    unsigned long  nextAt;
     char* testName = __func__;
     int testNumber;
 
@@ -302,7 +294,11 @@ int DelayAndDump(char* arg)
         {
             break;
         }
-
+        else
+        {
+            nextAt = (printingThread && printAt < stopAt) ? printAt : stopAt;
+            k_sleep((int)(nextAt - (currentTime - startTime)) + 1);
+        }
     }
     if (strlen(arg) <= 0)
     {
@@ -0,0 +1,21 @@
+
+@echo off
+ 
+REM The benchmarks time themselves with read_clock(), so their results depend
+REM on the host. That is why they are run here and not from RunMessagingTests.bat,
+REM whose output is compared against the golden run.
+
+set "benchPrefix=MessagingBench"
+
+REM Edit this list to change which benchmarks run
+set "benchNumbers=01 02 03 04 05 06 07 08 09 10 11 12 13"
+
+REM One BENCH line per run, key=value pairs, collected for comparison between releases
+set "resultsFile=MessagingBenchResults.txt"
+if exist "%resultsFile%" del "%resultsFile%"
+
+for %%a in (%benchNumbers%) do (
+    %benchPrefix%%%a | findstr /B "BENCH" >> "%resultsFile%"
+)
+
+type "%resultsFile%"
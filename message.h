@@ -5,22 +5,29 @@ typedef struct waiting_process *WaitingProcessPtr;
 typedef struct mail_slot *SlotPtr;
 typedef struct mailbox MailBox;
 
-typedef enum {MB_ZEROSLOT=0, MB_SINGLESLOT, MB_MULTISLOT, MB_MAXTYPES} MAILBOX_TYPE;
+typedef enum {MB_ZEROSLOT=0, MB_SINGLESLOT, MB_MULTISLOT, MB_MULTICAST, MB_SUBSCRIPTION, MB_MAXTYPES} MAILBOX_TYPE;     /* PERF ALTER multicast types */
 typedef enum {MBSTATUS_EMPTY=0, MBSTATUS_INUSE, MBSTATUS_RELEASED, MBSTATUS_MAX} MAILBOX_STATUS;
+typedef enum {SLOT_FREE=0, SLOT_QUEUED, SLOT_RESERVED, SLOT_ACQUIRED} SLOT_STATE;     /* PERF ADD */
 
 /* Block status values for use with block() */
 #define BLOCKED_RECEIVE 11
 #define BLOCKED_SEND    12
 #define BLOCKED_RELEASE 13
+#define BLOCKED_SLEEP   14      /* PERF ADD k_sleep or periodic_timer_wait */
+#define BLOCKED_DEVICE  15      /* PERF ADD wait_device on an I/O device */
 
 typedef struct mail_slot 
 {
    SlotPtr   pNextSlot;
    SlotPtr   pPrevSlot;
    int       mbox_id;
-   unsigned char message[MAX_MESSAGE];
    int       messageSize;
    /* other items as needed... */
+   int       slotClass;              /* PERF ADD size class the slot was carved for */
+   int       slotState;              /* PERF ADD SLOT_STATE, reserved/acquired slots are owned by a caller */
+   int       lane;                   /* PERF ADD message priority lane while queued */
+   int       refCount;               /* PERF ADD multicast: subscriptions still to receive the message */
+   unsigned char message[];          /* PERF ADD sized by the slot class, at most MAX_MESSAGE */
 
 } MailSlot;
 
@@ -30,6 +37,8 @@ typedef struct waiting_process
    WaitingProcessPtr    pPrevProcess;
    int                  pid;
    /* other items as needed... */
+   int                  priority;       /* PERF ADD wake priority, orders MBOX_WAKE_PRIORITY queues */
+   WaitingProcessPtr*   pLevelTails;    /* PERF ADD last node of each priority in its queue, NULL if FIFO */
 } WaitingProcess;
 
 struct mailbox 